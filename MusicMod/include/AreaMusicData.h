@@ -22,6 +22,8 @@ namespace AreaMusic
 		long long sourceStartMs = 0;
 		bool handled = false;
 		bool success = false;
+		// The override media is still decoding in the background; dispatch the request again on a later frame.
+		bool pending = false;
 		bool metadataPatched = false;
 		long long effectiveDurationMs = 0;
 		long long effectiveSourceStartMs = 0;
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "AreaMusicData.h"
+#include "AudioDecodeService.h"
 #include "IEventListener.h"
 
 #include "GameData.h"
@@ -48,8 +49,14 @@ private:
 	{
 		std::string path{};
 		std::vector<uint8_t> bytes{};
+		std::shared_ptr<const MappedFile> mappedFile{};
+		const uint8_t* mappedBytes = nullptr;
+		size_t mappedSize = 0;
 		uint32_t sourcePluginId = areaMusicOverrideSourcePluginId;
 		long long durationMs = 0;
+
+		const uint8_t* Data() const { return mappedBytes ? mappedBytes : bytes.data(); }
+		size_t Size() const { return mappedBytes ? mappedSize : bytes.size(); }
 	};
 
 	struct LiveAreaMusicMemoryBackup
@@ -71,6 +78,13 @@ private:
 		uint32_t trackTimingCount = 0;
 	};
 
+	enum class MediaLoadStatus
+	{
+		Ready,
+		Pending,
+		Failed
+	};
+
 	struct NativeAreaMusicBackup
 	{
 		bool valid = false;
@@ -85,7 +99,8 @@ private:
 	static void HandleRegisterRequest(AreaMusic::RegisterRequest&);
 
 	static bool ResolveWwiseMediaFunctions();
-	static bool LoadAreaMusicManager(const char*);
+	static MediaLoadStatus LoadAreaMusicManager(const char*, AudioDecoder::OutputEncoding);
+	static void PreloadInternalWwiseArchive();
 	static bool LoadInternalWwiseMedia(const MusicData*);
 	static bool LoadInternalWwiseMediaFromGameArchive(const MusicData*, AreaMusicManagerBuffer&);
 	static void Unset();
@@ -123,6 +138,7 @@ private:
 	inline static std::atomic<uintptr_t> wwiseObjectRegistryAddress{ 0 };
 	inline static std::mutex areaMusicMetadataMutex{};
 	inline static std::unique_ptr<AreaMusicManagerBuffer> areaMusicOverrideBuffer{};
+	inline static std::shared_ptr<AudioDecodeService::Job> pendingOverrideDecode{};
 	inline static std::vector<std::unique_ptr<AreaMusicManagerBuffer>> retiredAreaMusicManagerBuffers{};
 	inline static LiveAreaMusicMetadataBackup liveAreaMusicMetadataBackup{};
 	inline static uint32_t areaMusicOverrideRegisteredMediaId = 0;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AudioDecoder.h"
+
+// Runs AudioDecoder::LoadWwiseMedia on background workers, so the render thread only has to poll for results.
+class AudioDecodeService
+{
+public:
+	enum class Priority
+	{
+		Prefetch = 0,
+		Playback = 1
+	};
+
+	struct Result
+	{
+		bool success = false;
+		bool canceled = false;
+		AudioDecoder::WwiseMediaBuffer media{};
+	};
+
+	// Called on the worker thread that finished the job, just before its result becomes ready.
+	using Callback = std::function<void(const std::string& path, const Result&)>;
+
+	class Job
+	{
+	public:
+		const std::string& Path() const { return path_; }
+		Priority GetPriority() const { return priority_; }
+		AudioDecoder::OutputEncoding GetEncoding() const { return encoding_; }
+
+		// A queued job is dropped; a running decode stops at its next check and reports canceled.
+		void Cancel() { canceled_ = true; }
+		bool IsCanceled() const { return canceled_; }
+
+		bool IsReady() const;
+		// Moves the result out, waiting for it if needed; call at most once.
+		Result Take();
+
+	private:
+		friend class AudioDecodeService;
+
+		std::string path_{};
+		Priority priority_ = Priority::Playback;
+		AudioDecoder::OutputEncoding encoding_ = AudioDecoder::OutputEncoding::Pcm;
+		uint64_t sequence_ = 0;
+		std::atomic<bool> canceled_ = false;
+		Callback callback_{};
+		std::promise<Result> promise_{};
+		std::future<Result> future_{};
+	};
+
+	static AudioDecodeService& GetInstance();
+
+	// Higher priorities run first, then jobs in the order they were queued.
+	std::shared_ptr<Job> Queue(
+		const std::string& path,
+		Priority priority,
+		AudioDecoder::OutputEncoding encoding = AudioDecoder::OutputEncoding::Pcm,
+		Callback callback = {}
+	);
+
+private:
+	AudioDecodeService() = default;
+
+	void StartWorkers();
+	void WorkerLoop();
+	std::shared_ptr<Job> PopNextJob();
+	static void Complete(Job&, Result&&);
+
+	inline static constexpr const char* logPrefix = "Audio Decode Service";
+	inline static constexpr size_t workerCount = 2;
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::vector<std::shared_ptr<Job>> queue_;
+	uint64_t nextSequence_ = 0;
+	bool workersStarted_ = false;
+};
@@ -1,26 +1,61 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "AudioProbe.h"
+
+class MappedFile;
+
 namespace AudioDecoder
 {
+	// What decoded custom songs are handed to Wwise as. ImaAdpcm keeps a quarter of the memory at the cost of
+	// some quality and a one-time encode the transcode cache absorbs.
+	enum class OutputEncoding
+	{
+		Pcm,
+		ImaAdpcm
+	};
+
 	struct WwiseMediaBuffer
 	{
 		std::string path{};
 		std::vector<uint8_t> bytes{};
+		// Set instead of bytes when the media is served from a mapped transcode cache entry; the mapping stays
+		// alive as long as any buffer refers to it.
+		std::shared_ptr<const MappedFile> mappedFile{};
+		const uint8_t* mappedBytes = nullptr;
+		size_t mappedSize = 0;
 		uint32_t sourcePluginId = 0x00040001;
 		long long durationMs = 0;
 		uint32_t sampleRate = 0;
 		uint32_t channels = 0;
 		uint32_t bitsPerSample = 0;
+		// Set when building the media took a real transcode, which makes it worth keeping in the transcode cache.
 		bool decodedToPcm = false;
+
+		const uint8_t* Data() const { return mappedBytes ? mappedBytes : bytes.data(); }
+		size_t Size() const { return mappedBytes ? mappedSize : bytes.size(); }
 	};
 
 	bool IsSupportedCustomAudioPath(const std::string& path);
 	bool IsSupportedCustomAudioPath(const std::filesystem::path& path);
 
-	bool LoadWwiseMedia(const std::string& path, WwiseMediaBuffer& output);
+	uint32_t GetSourcePluginId(OutputEncoding encoding);
+
+	// Reads duration, format and codec from the file's headers without decoding anything, cheap enough to run on
+	// every song in a library scan. Fails for files AudioProbe does not recognize.
+	bool Probe(const std::string& path, AudioProbe::AudioInfo& info);
+
+	// Blocking; canceled is polled between decode steps. Use AudioDecodeService from the render thread.
+	bool LoadWwiseMedia(
+		const std::string& path,
+		WwiseMediaBuffer& output,
+		const std::atomic<bool>* canceled = nullptr,
+		OutputEncoding encoding = OutputEncoding::Pcm
+	);
 }
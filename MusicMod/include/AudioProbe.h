@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Reads what an audio file holds from its headers alone, so a library scan can learn durations without decoding
+// any samples. Only depends on the standard library.
+namespace AudioProbe
+{
+	enum class Codec
+	{
+		Unknown,
+		Pcm,
+		ImaAdpcm,
+		WwiseVorbis,
+		Flac,
+		Vorbis,
+		Opus,
+		Mp1,
+		Mp2,
+		Mp3,
+		Aac,
+		Alac
+	};
+
+	struct AudioInfo
+	{
+		Codec codec = Codec::Unknown;
+		// What a decoder produces; Opus always decodes at 48 kHz whatever rate it was encoded from.
+		uint32_t sampleRate = 0;
+		uint32_t channels = 0;
+		// 0 when the headers do not say.
+		long long durationMs = 0;
+		// Set when the duration was worked out from the file size and bitrate instead of a stored sample count,
+		// which is only right for constant bitrate MPEG audio.
+		bool durationEstimated = false;
+	};
+
+	const char* GetCodecName(Codec codec);
+
+	// Recognizes RIFF/WAVE (including Wwise .wem), AIFF/AIFC, FLAC, Ogg Vorbis/Opus/FLAC, MPEG audio and MP4 by
+	// their contents. Only the first few kilobytes are read, plus the last Ogg page or the MP4 boxes describing
+	// the audio track, wherever they are.
+	bool Probe(const uint8_t* bytes, size_t size, AudioInfo& info);
+}
@@ -16,12 +16,69 @@ namespace DecimaArchiveReader
 		size_t copiedBytes = 0;
 	};
 
+	struct ReadFileRequest
+	{
+		std::string normalizedPath{};
+		// When non-zero, looked up directly instead of hashing normalizedPath (see DecimaHash.h).
+		uint64_t pathHash = 0;
+		// Required for whole-entry reads; 0 skips the size check on range reads.
+		uint32_t expectedSize = 0;
+		// A non-zero length reads only [rangeOffset, rangeOffset + rangeLength) of the entry.
+		uint32_t rangeOffset = 0;
+		uint32_t rangeLength = 0;
+		std::vector<uint8_t> output{};
+		ReadFileResult result{};
+	};
+
+	// Identifies the pack that currently serves an entry, so derived data can be invalidated when it changes.
+	struct ArchiveFileStamp
+	{
+		uint32_t size = 0;
+		uint64_t packSize = 0;
+		uint64_t packLastWriteTime = 0;
+	};
+
+	struct ChunkCacheStats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		size_t cachedBytes = 0;
+		size_t budgetBytes = 0;
+	};
+
 	std::string BuildStreamedWemPath(uint32_t sourceId);
-	std::wstring GetInitialArchivePath();
 
-	ReadFileResult ReadInitialArchiveFile(
+	// Indexes every pack under data/ and packed_GDK/ once per session. The merged index is cached in
+	// walkingman_archives.idx and reused while the packs keep their sizes and write times.
+	bool LoadArchiveIndex(std::string& error);
+
+	bool GetArchiveFileStamp(const std::string& normalizedPath, ArchiveFileStamp& stamp, std::string& error);
+	bool GetArchiveFileStamp(uint64_t pathHash, ArchiveFileStamp& stamp, std::string& error);
+
+	// Extracts every request in one pass; chunks shared by several entries are decompressed once.
+	void ReadArchiveFiles(std::vector<ReadFileRequest>& requests);
+
+	// Decompressed chunks are kept in an LRU sized by archiveChunkCacheSizeMB; 0 disables it.
+	ChunkCacheStats GetChunkCacheStats();
+
+	ReadFileResult ReadArchiveFile(
 		const std::string& normalizedPath,
 		uint32_t expectedSize,
 		std::vector<uint8_t>& output
 	);
+	ReadFileResult ReadArchiveFile(uint64_t pathHash, uint32_t expectedSize, std::vector<uint8_t>& output);
+
+	// Decompresses only the chunks covering the range, e.g. to probe a stream's RIFF header.
+	ReadFileResult ReadArchiveFileRange(
+		const std::string& normalizedPath,
+		uint32_t offset,
+		uint32_t length,
+		std::vector<uint8_t>& output
+	);
+
+	// Only run when runBenchmarks is set: builds synthetic plain and encrypted packs with 1K to 1M entries in the
+	// temp directory, logs index build, lookup and extraction timings through the reader's own code paths, then
+	// deletes the directory again.
+	void LogBenchmarks();
 }
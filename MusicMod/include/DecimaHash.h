@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Decima names archive entries by the MurmurHash3 of their path. Everything here is constexpr so hashes of
+// paths known ahead of time can be produced without building strings or hashing on the lookup path.
+namespace DecimaHash
+{
+	inline constexpr uint32_t pathHashSeed = 0x2a;
+
+	constexpr uint64_t Rotl64(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	constexpr uint64_t Fmix64(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdull;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	// Byte is char or uint8_t; the bytes are assembled one at a time so the function stays usable in constant
+	// expressions.
+	template <typename Byte>
+	constexpr uint64_t LoadLe64(const Byte* bytes, size_t count = 8)
+	{
+		uint64_t value = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (i * 8);
+		}
+		return value;
+	}
+
+	template <typename Byte>
+	constexpr std::array<uint64_t, 2> MurmurHash3X64_128(const Byte* data, size_t length, uint32_t seed = pathHashSeed)
+	{
+		constexpr uint64_t c1 = 0x87c37b91114253d5ull;
+		constexpr uint64_t c2 = 0x4cf5ad432745937full;
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		const size_t blockCount = length / 16;
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			uint64_t k1 = LoadLe64(data + i * 16);
+			uint64_t k2 = LoadLe64(data + i * 16 + 8);
+
+			k1 *= c1;
+			k1 = Rotl64(k1, 31);
+			k1 *= c2;
+			h1 ^= k1;
+
+			h1 = Rotl64(h1, 27);
+			h1 += h2;
+			h1 = h1 * 5 + 0x52dce729;
+
+			k2 *= c2;
+			k2 = Rotl64(k2, 33);
+			k2 *= c1;
+			h2 ^= k2;
+
+			h2 = Rotl64(h2, 31);
+			h2 += h1;
+			h2 = h2 * 5 + 0x38495ab5;
+		}
+
+		// The tail is at most 15 bytes: up to 8 feed k1 and the rest feed k2.
+		const Byte* tail = data + blockCount * 16;
+		const size_t tailLength = length & 15;
+		if (tailLength > 8)
+		{
+			uint64_t k2 = LoadLe64(tail + 8, tailLength - 8);
+			k2 *= c2;
+			k2 = Rotl64(k2, 33);
+			k2 *= c1;
+			h2 ^= k2;
+		}
+		if (tailLength > 0)
+		{
+			uint64_t k1 = LoadLe64(tail, tailLength < 8 ? tailLength : 8);
+			k1 *= c1;
+			k1 = Rotl64(k1, 31);
+			k1 *= c2;
+			h1 ^= k1;
+		}
+
+		h1 ^= length;
+		h2 ^= length;
+		h1 += h2;
+		h2 += h1;
+		h1 = Fmix64(h1);
+		h2 = Fmix64(h2);
+		h1 += h2;
+		h2 += h1;
+		return { h1, h2 };
+	}
+
+	// Decima hashes the path including its NUL terminator, so path[length] must be readable and zero;
+	// std::string::c_str() and string literals both qualify.
+	constexpr uint64_t ComputePathHash(const char* path, size_t length)
+	{
+		return MurmurHash3X64_128(path, length + 1)[0];
+	}
+
+	inline constexpr char streamedWemPathPrefix[] = "ds/sounds/streamed_wem_in_bank/generated/windows/";
+	inline constexpr char streamedWemPathSuffix[] = ".core.stream";
+
+	// Holds the path NUL-terminated; sized for the longest uint32_t source id.
+	struct StreamedWemPath
+	{
+		std::array<char, sizeof(streamedWemPathPrefix) + 10 + sizeof(streamedWemPathSuffix) - 1> chars{};
+		size_t length = 0;
+	};
+
+	constexpr StreamedWemPath BuildStreamedWemPath(uint32_t sourceId)
+	{
+		StreamedWemPath path{};
+		for (size_t i = 0; i + 1 < sizeof(streamedWemPathPrefix); i++)
+		{
+			path.chars[path.length++] = streamedWemPathPrefix[i];
+		}
+
+		char digits[10]{};
+		size_t digitCount = 0;
+		do
+		{
+			digits[digitCount++] = static_cast<char>('0' + sourceId % 10);
+			sourceId /= 10;
+		} while (sourceId != 0);
+		while (digitCount > 0)
+		{
+			path.chars[path.length++] = digits[--digitCount];
+		}
+
+		for (size_t i = 0; i + 1 < sizeof(streamedWemPathSuffix); i++)
+		{
+			path.chars[path.length++] = streamedWemPathSuffix[i];
+		}
+		path.chars[path.length] = '\0';
+		return path;
+	}
+
+	constexpr uint64_t ComputeStreamedWemPathHash(uint32_t sourceId)
+	{
+		const StreamedWemPath path = BuildStreamedWemPath(sourceId);
+		return ComputePathHash(path.chars.data(), path.length);
+	}
+
+	// The published x64_128 vector, with seed 0 and no terminator hashed.
+	static_assert(
+		MurmurHash3X64_128("The quick brown fox jumps over the lazy dog", 43, 0)[0] == 0xe34bbc7bbc071b6cull
+		&& MurmurHash3X64_128("The quick brown fox jumps over the lazy dog", 43, 0)[1] == 0x7a433ca9c49a9347ull,
+		"MurmurHash3 does not match the reference implementation"
+	);
+
+	// Produced by the runtime path building and hashing this header replaced; the ids cover one digit, a real
+	// song and the longest id.
+	static_assert(ComputeStreamedWemPathHash(0) == 0xbebe14a101156c40ull, "streamed WEM path hash changed");
+	static_assert(ComputeStreamedWemPathHash(439722904) == 0x795e41ce868cab73ull, "streamed WEM path hash changed");
+	static_assert(ComputeStreamedWemPathHash(4294967295u) == 0xd923abb16f100855ull, "streamed WEM path hash changed");
+}
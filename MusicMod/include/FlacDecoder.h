@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decodes FLAC in process, so lossless songs play without Media Foundation or ffmpeg. Only depends on the
+// standard library.
+namespace FlacDecoder
+{
+	struct StreamInfo
+	{
+		uint32_t sampleRate = 0;
+		uint32_t channels = 0;
+		// Of the source; the decoded output is always 16-bit.
+		uint32_t bitsPerSample = 0;
+		uint64_t totalSamples = 0;
+		// WAVE speaker mask matching FLAC's fixed channel order.
+		uint32_t channelMask = 0;
+	};
+
+	// Appends the whole stream to pcm as interleaved 16-bit little-endian samples, keeping whatever pcm already
+	// holds in front of them. Sources of 4 to 24 bits per sample are supported; wider samples keep their top 16
+	// bits. Fails instead of growing pcm by more than maxPcmBytes, and stops between frames once canceled is set.
+	bool Decode(
+		const uint8_t* bytes,
+		size_t size,
+		std::vector<uint8_t>& pcm,
+		StreamInfo& info,
+		size_t maxPcmBytes,
+		const std::atomic<bool>* canceled = nullptr
+	);
+}
@@ -65,6 +65,8 @@ struct InternalWwiseAreaTrackData
 	uint32_t sourceId = 0;
 	uint32_t streamMediaSize = 0;
 	uint32_t sourcePluginId = 0;
+	// Path hash of the source's streamed WEM, filled in with the song database so lookups never rebuild the path.
+	uint64_t streamPathHash = 0;
 };
 
 struct MusicData
@@ -80,6 +82,7 @@ struct MusicData
 	bool active = false;
 	bool customAreaTrack = false;
 	const char* customWemPath = nullptr;
+	bool compressCustomAudio = false; // Play the custom song as ADPCM instead of PCM
 	InternalWwiseAreaTrackData internalWwiseAreaTrack{};
 };
 
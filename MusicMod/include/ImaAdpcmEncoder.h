@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Encodes 16-bit PCM into the IMA ADPCM block layout Wwise's ADPCM source plugin plays, a quarter of the size of
+// the PCM it replaces. Only depends on the standard library.
+namespace ImaAdpcmEncoder
+{
+	// Each block holds, per channel, a 4-byte header (first sample and step index) followed by 64 samples of
+	// 4 bits. A block's channels are stored one after another rather than interleaved.
+	constexpr uint32_t samplesPerBlock = 65;
+	constexpr uint32_t bytesPerChannelBlock = 36;
+	constexpr uint32_t maxChannels = 8;
+
+	size_t GetBlockCount(size_t frameCount);
+	size_t GetEncodedSize(size_t frameCount, uint32_t channels);
+
+	// Encodes interleaved little-endian samples; the last block is padded by repeating the final frame.
+	// target needs GetEncodedSize bytes and may overlap pcm as long as it does not start after it, so a decode
+	// buffer can be encoded in place.
+	bool Encode(const uint8_t* pcm, size_t frameCount, uint32_t channels, uint8_t* target);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <Windows.h>
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// A copy-on-write view may be handed to code that expects writable memory: writes land in private pages and
+	// never reach the file.
+	bool Open(const std::wstring&, bool copyOnWrite = false);
+	void Close();
+
+	// Copies from the view; returns false instead of faulting if the backing file became unreadable.
+	bool Read(uint64_t, void*, size_t) const;
+	bool Contains(uint64_t, uint64_t) const;
+	// Asks the memory manager to page the range in asynchronously; later reads of it should not block on I/O.
+	void Prefetch(uint64_t, uint64_t) const;
+
+	bool IsOpen() const { return data_ != nullptr; }
+	const uint8_t* Data() const { return data_; }
+	uint64_t Size() const { return size_; }
+
+private:
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = nullptr;
+	const uint8_t* data_ = nullptr;
+	uint64_t size_ = 0;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AudioDecoder.h"
+
+namespace MediaCache
+{
+	// Everything that decides whether cached bytes still match what the game archive would produce.
+	struct InternalMediaKey
+	{
+		uint32_t sourceId = 0;
+		uint32_t mediaSize = 0;
+		uint64_t packSize = 0;
+		uint64_t packLastWriteTime = 0;
+	};
+
+	// Reads walkingman_cache/<sourceId>.wem in one sequential read; rejects stale or damaged entries.
+	bool LoadInternalMedia(const InternalMediaKey& key, std::vector<uint8_t>& bytes);
+	bool StoreInternalMedia(const InternalMediaKey& key, const std::vector<uint8_t>& bytes);
+
+	// Decoded custom songs, keyed by the source file's absolute path, size and last write time. A hit maps the
+	// entry instead of reading it, so the media is paged in as Wwise plays it. Entries beyond transcodeCacheSizeMB
+	// are evicted least recently used first.
+	bool LoadTranscodedMedia(const std::string& sourcePath, AudioDecoder::WwiseMediaBuffer& media);
+	bool StoreTranscodedMedia(const std::string& sourcePath, const AudioDecoder::WwiseMediaBuffer& media);
+}
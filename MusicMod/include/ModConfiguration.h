@@ -3,6 +3,7 @@
 #include <functional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "ordered_set.h"
 
@@ -15,7 +16,8 @@ namespace ModConfiguration
 		NONE,
 		GLOBAL_SETTINGS,
 		ACTIVE_SONGS,
-		INACTIVE_SONGS
+		INACTIVE_SONGS,
+		COMPRESSED_SONGS
 	};
 
 	extern const std::string modPublicName;
@@ -43,11 +45,19 @@ namespace ModConfiguration
 
 	extern bool customSongsEnabled;
 	extern std::string customSongsFolderPath;
+	extern bool compressCustomSongs;
 
 	extern bool allowScriptedSongs;
 	extern bool showMusicPlayerUI;
 
+	extern uint32_t archiveChunkCacheSizeMB;
+	extern uint32_t transcodeCacheSizeMB;
+
+	extern bool runBenchmarks;
+
 	extern tsl::ordered_set<std::string> activePlaylist;
+	// Custom songs to play as ADPCM even while compressCustomSongs is off
+	extern std::unordered_set<std::string> compressedSongs;
 
 	extern const std::unordered_map<std::string, std::function<void(const std::string&)>> parameterSetters;
 
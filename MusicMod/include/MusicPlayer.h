@@ -115,6 +115,7 @@ private:
 	inline static const MusicData* pendingMusicData = nullptr;
 	inline static bool pendingMusicDisplayDescription = true;
 	inline static bool pendingMusicOverridePrepared = false;
+	inline static long long pendingMusicResumeOffsetMs = 0;
 	inline static std::chrono::time_point<std::chrono::steady_clock> pendingMusicStartTime;
 
 	inline static std::atomic<bool> btTerritoryBlocksMusic = false;
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Recognizes uncompressed audio files whose samples Wwise can play as they are, so loading them only needs a new
+// header instead of a decode. Only depends on the standard library.
+namespace PcmFileParser
+{
+	struct PcmLayout
+	{
+		uint32_t channels = 0;
+		uint32_t sampleRate = 0;
+		uint32_t bitsPerSample = 0;
+		// From WAVE_FORMAT_EXTENSIBLE; 0 when the file does not say.
+		uint32_t channelMask = 0;
+		size_t dataOffset = 0;
+		size_t dataSize = 0;
+		// AIFF stores samples big endian; they have to be swapped before Wwise can use them.
+		bool bigEndian = false;
+	};
+
+	// Accepts 16-bit integer PCM in RIFF/WAVE (plain or extensible) and AIFF/AIFC ("NONE", "twos" or "sowt").
+	// A data chunk that claims more than the file holds is clipped to what is there, as long as whole frames remain.
+	bool Parse(const uint8_t* bytes, size_t size, PcmLayout& layout);
+}
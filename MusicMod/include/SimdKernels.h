@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SimdKernels
+{
+	// target[i] = source[i] ^ key[i & 15]. Source and target may be the same buffer.
+	void XorRepeatingKey16(const uint8_t* source, uint8_t* target, size_t size, const uint8_t key[16]);
+
+	// Hashes count independent 16-byte keys with MurmurHash3 x64/128. keys holds count * 16 bytes and hashes
+	// receives two words per key, in the same order a single-key MurmurHash3 call returns them.
+	void MurmurHash3X64_128Keys16(const uint8_t* keys, size_t count, uint32_t seed, uint64_t* hashes);
+
+	// Swaps the two bytes of each of count 16-bit samples, e.g. big-endian AIFF audio into the little-endian
+	// order Wwise plays. Source and target may be the same buffer.
+	void ByteSwap16(const uint8_t* source, uint8_t* target, size_t count);
+
+	constexpr uint32_t maxDownmixChannels = 8;
+
+	// Widen count little-endian integer samples to floats in [-1, 1). Int24 samples are packed in 3 bytes.
+	void Int16ToFloat(const uint8_t* source, float* target, size_t count);
+	void Int24ToFloat(const uint8_t* source, float* target, size_t count);
+	void Int32ToFloat(const uint8_t* source, float* target, size_t count);
+
+	// Mixes frames of up to maxDownmixChannels interleaved channels into interleaved stereo. coefficients holds
+	// the left gain of every channel followed by the right gain of every channel.
+	void DownmixToStereo(
+		const float* source,
+		size_t frames,
+		uint32_t channels,
+		const float* coefficients,
+		float* target
+	);
+
+	// Narrows floats in [-1, 1) to 16-bit little-endian samples with triangular dither, clipping whatever falls
+	// outside. The dither only depends on each sample's position in the stream, so a stream converted in pieces,
+	// each passing its first sample's position, matches one converted in a single call.
+	void FloatToInt16Dithered(const float* source, uint8_t* target, size_t count, uint32_t position);
+
+	bool HasAvx2();
+
+	// Only run when runBenchmarks is set: times each kernel path on a synthetic buffer and writes the throughput
+	// to the log.
+	void LogBenchmarks();
+}
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstdint>
 #include <iomanip>
@@ -66,6 +67,51 @@ namespace Utils {
 		return true;
 	}
 
+	// Writes through a sibling temporary file so a crash never leaves a truncated file behind.
+	static bool WriteFileBytesWide(const std::wstring& path, const std::vector<uint8_t>& bytes)
+	{
+		if (bytes.size() > (std::numeric_limits<DWORD>::max)())
+		{
+			return false;
+		}
+
+		const std::wstring tempPath = path + L".tmp";
+		HANDLE file = CreateFileW(
+			tempPath.c_str(),
+			GENERIC_WRITE,
+			0,
+			nullptr,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr
+		);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		DWORD written = 0;
+		const BOOL ok = WriteFile(
+			file,
+			bytes.data(),
+			static_cast<DWORD>(bytes.size()),
+			&written,
+			nullptr
+		);
+		CloseHandle(file);
+		if (
+			!ok
+			|| static_cast<size_t>(written) != bytes.size()
+			|| !MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)
+		)
+		{
+			DeleteFileW(tempPath.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
 	static bool ReadFileBytesAt(HANDLE file, uint64_t offset, void* bytes, size_t size)
 	{
 		if (!file || file == INVALID_HANDLE_VALUE || (!bytes && size != 0))
@@ -173,7 +219,13 @@ namespace Utils {
 		return true;
 	}
 
-	static bool RunProcessAndWait(std::wstring commandLine, DWORD timeoutMs, DWORD& exitCode)
+	// A set canceled flag terminates the process early; that reports the same as a timeout.
+	static bool RunProcessAndWait(
+		std::wstring commandLine,
+		DWORD timeoutMs,
+		DWORD& exitCode,
+		const std::atomic<bool>* canceled = nullptr
+	)
 	{
 		STARTUPINFOW startupInfo{};
 		startupInfo.cb = sizeof(startupInfo);
@@ -197,7 +249,24 @@ namespace Utils {
 			return false;
 		}
 
-		const DWORD waitResult = WaitForSingleObject(processInfo.hProcess, timeoutMs);
+		constexpr DWORD cancelPollMs = 50;
+		const ULONGLONG startTick = GetTickCount64();
+		DWORD waitResult = WAIT_TIMEOUT;
+		for (;;)
+		{
+			const ULONGLONG elapsedMs = GetTickCount64() - startTick;
+			if (elapsedMs >= timeoutMs || (canceled && canceled->load()))
+			{
+				break;
+			}
+			const DWORD remainingMs = static_cast<DWORD>(timeoutMs - elapsedMs);
+			const DWORD waitMs = canceled ? (std::min)(remainingMs, cancelPollMs) : remainingMs;
+			waitResult = WaitForSingleObject(processInfo.hProcess, waitMs);
+			if (waitResult != WAIT_TIMEOUT)
+			{
+				break;
+			}
+		}
 		if (waitResult == WAIT_TIMEOUT)
 		{
 			TerminateProcess(processInfo.hProcess, 1);
@@ -211,6 +280,151 @@ namespace Utils {
 		return waitResult != WAIT_TIMEOUT;
 	}
 
+	// Appends the process's stdout to output while it runs, so nothing is staged on disk. Exceeding maxOutputBytes,
+	// the timeout or a set canceled flag terminates the process and fails.
+	static bool RunProcessCapturingOutput(
+		std::wstring commandLine,
+		DWORD timeoutMs,
+		DWORD& exitCode,
+		std::vector<uint8_t>& output,
+		size_t maxOutputBytes,
+		const std::atomic<bool>* canceled = nullptr
+	)
+	{
+		// A large pipe buffer keeps the child from stalling on a full pipe between our reads.
+		constexpr DWORD pipeBufferBytes = 1u << 20;
+		constexpr DWORD idlePollMs = 5;
+
+		SECURITY_ATTRIBUTES pipeAttributes{};
+		pipeAttributes.nLength = sizeof(pipeAttributes);
+		pipeAttributes.bInheritHandle = TRUE;
+		HANDLE readPipe = nullptr;
+		HANDLE writePipe = nullptr;
+		if (!CreatePipe(&readPipe, &writePipe, &pipeAttributes, pipeBufferBytes))
+		{
+			return false;
+		}
+		SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+		// The child inherits only its own write end. Decodes run on several workers, and a child that also
+		// inherited another decode's write end would keep that pipe open until it exited.
+		SIZE_T attributeListSize = 0;
+		InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeListSize);
+		std::vector<uint8_t> attributeListBytes(attributeListSize);
+		auto attributeList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeListBytes.data());
+		if (attributeListBytes.empty() || !InitializeProcThreadAttributeList(attributeList, 1, 0, &attributeListSize))
+		{
+			CloseHandle(readPipe);
+			CloseHandle(writePipe);
+			return false;
+		}
+		HANDLE inheritedHandles[] = { writePipe };
+		const BOOL restricted = UpdateProcThreadAttribute(
+			attributeList,
+			0,
+			PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+			inheritedHandles,
+			sizeof(inheritedHandles),
+			nullptr,
+			nullptr
+		);
+
+		STARTUPINFOEXW startupInfo{};
+		startupInfo.StartupInfo.cb = sizeof(startupInfo);
+		startupInfo.StartupInfo.dwFlags = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
+		startupInfo.StartupInfo.wShowWindow = SW_HIDE;
+		startupInfo.StartupInfo.hStdOutput = writePipe;
+		startupInfo.lpAttributeList = attributeList;
+
+		PROCESS_INFORMATION processInfo{};
+		const BOOL created = restricted && CreateProcessW(
+			nullptr,
+			commandLine.data(),
+			nullptr,
+			nullptr,
+			TRUE,
+			CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT,
+			nullptr,
+			nullptr,
+			&startupInfo.StartupInfo,
+			&processInfo
+		);
+		DeleteProcThreadAttributeList(attributeList);
+		// Only the child may keep the write end open, otherwise the pipe never reports the end of the output.
+		CloseHandle(writePipe);
+		if (!created)
+		{
+			CloseHandle(readPipe);
+			return false;
+		}
+
+		const size_t startSize = output.size();
+		const ULONGLONG startTick = GetTickCount64();
+		bool completed = false;
+		for (;;)
+		{
+			if (GetTickCount64() - startTick >= timeoutMs || (canceled && canceled->load()))
+			{
+				break;
+			}
+
+			DWORD available = 0;
+			if (!PeekNamedPipe(readPipe, nullptr, 0, nullptr, &available, nullptr))
+			{
+				// The child closed its stdout, normally by exiting, and everything it wrote has been read.
+				completed = GetLastError() == ERROR_BROKEN_PIPE;
+				break;
+			}
+			if (available == 0)
+			{
+				WaitForSingleObject(processInfo.hProcess, idlePollMs);
+				continue;
+			}
+			if (available > maxOutputBytes - (output.size() - startSize))
+			{
+				break;
+			}
+
+			const size_t writeOffset = output.size();
+			output.resize(writeOffset + available);
+			DWORD read = 0;
+			const BOOL ok = ReadFile(readPipe, output.data() + writeOffset, available, &read, nullptr);
+			output.resize(writeOffset + read);
+			if (!ok)
+			{
+				completed = GetLastError() == ERROR_BROKEN_PIPE;
+				break;
+			}
+		}
+		CloseHandle(readPipe);
+
+		if (!completed || WaitForSingleObject(processInfo.hProcess, 5000) == WAIT_TIMEOUT)
+		{
+			TerminateProcess(processInfo.hProcess, 1);
+			WaitForSingleObject(processInfo.hProcess, 5000);
+			completed = false;
+		}
+
+		exitCode = 1;
+		GetExitCodeProcess(processInfo.hProcess, &exitCode);
+		CloseHandle(processInfo.hThread);
+		CloseHandle(processInfo.hProcess);
+		return completed;
+	}
+
+	static bool GetFileSizeAndWriteTime(const std::wstring& path, uint64_t& size, uint64_t& lastWriteTime)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes{};
+		if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes))
+		{
+			return false;
+		}
+		size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		lastWriteTime = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32)
+			| attributes.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
 	static bool IsExistingFile(const std::wstring& path)
 	{
 		const DWORD attributes = GetFileAttributesW(path.c_str());
@@ -706,6 +920,12 @@ namespace Utils {
 		bytes.push_back(static_cast<uint8_t>((value >> 24) & 0xff));
 	}
 
+	static void AppendLe64(std::vector<uint8_t>& bytes, uint64_t value)
+	{
+		AppendLe32(bytes, static_cast<uint32_t>(value & 0xffffffffull));
+		AppendLe32(bytes, static_cast<uint32_t>(value >> 32));
+	}
+
 	static std::string FilenameFromPath(const std::string& path)
 	{
 		const size_t slashPos = path.find_last_of("\\/");
@@ -9,8 +9,10 @@
 
 #include "AudioDecoder.h"
 #include "DecimaArchiveReader.h"
+#include "DecimaHash.h"
 #include "GameData.h"
 #include "Logger.h"
+#include "MediaCache.h"
 #include "MemoryUtils.h"
 #include "ModConfiguration.h"
 #include "ModManager.h"
@@ -29,6 +31,7 @@ namespace
 	constexpr size_t liveTrackTimingStride = 0x1c;
 	constexpr uint32_t wwiseTicksPerMillisecond = 48;
 	constexpr uint32_t maxInternalWwiseMediaSize = DecimaArchiveReader::maxExtractedFileSize;
+	constexpr uint32_t internalWwiseHeaderProbeSize = 4096;
 
 	uint32_t MillisecondsToWwiseTicks(long long milliseconds)
 	{
@@ -118,6 +121,13 @@ namespace
 			|| std::memcmp(bytes, "RIFX", 4) == 0;
 		return riff && std::memcmp(bytes + 8, "WAVE", 4) == 0;
 	}
+
+	uint64_t GetStreamPathHash(const InternalWwiseAreaTrackData& internalAreaTrack)
+	{
+		return internalAreaTrack.streamPathHash != 0
+			? internalAreaTrack.streamPathHash
+			: DecimaHash::ComputeStreamedWemPathHash(internalAreaTrack.sourceId);
+	}
 }
 
 void AreaMusicManager::ReleaseWwiseObject(void* object)
@@ -193,6 +203,11 @@ void AreaMusicManager::OnEvent(const ModEvent& event)
 {
 	switch (event.type)
 	{
+		case ModEventType::ScanCompleted:
+		{
+			PreloadInternalWwiseArchive();
+			break;
+		}
 		case ModEventType::FrameRendered:
 		{
 			InstallWwiseObjectLookupHook();
@@ -724,14 +739,14 @@ bool AreaMusicManager::PatchLiveAreaMusicMetadata(
 	const uint32_t sourceId = AreaMusic::OverrideTarget.sourceId;
 	const uint32_t mediaSize = areaMusicOverrideBuffer
 		? static_cast<uint32_t>((std::min)(
-			areaMusicOverrideBuffer->bytes.size(),
+			areaMusicOverrideBuffer->Size(),
 			static_cast<size_t>((std::numeric_limits<uint32_t>::max)())
 		))
 		: 0;
 	const uint32_t sourcePluginId = areaMusicOverrideBuffer
 		? areaMusicOverrideBuffer->sourcePluginId
 		: areaMusicOverrideSourcePluginId;
-	const bool patchSourceMediaMetadata = areaMusicOverrideBuffer && !areaMusicOverrideBuffer->bytes.empty();
+	const bool patchSourceMediaMetadata = areaMusicOverrideBuffer && areaMusicOverrideBuffer->Size() != 0;
 
 	void* segment = LookupWwiseObject(AreaMusic::OverrideTarget.segmentId);
 	void* track = LookupWwiseObject(AreaMusic::OverrideTarget.trackId);
@@ -1263,22 +1278,70 @@ bool AreaMusicManager::ResolveWwiseMediaFunctions()
 	return true;
 }
 
-bool AreaMusicManager::LoadAreaMusicManager(const char* overridePath)
+AreaMusicManager::MediaLoadStatus AreaMusicManager::LoadAreaMusicManager(
+	const char* overridePath,
+	AudioDecoder::OutputEncoding encoding
+)
 {
 	if (!overridePath || !overridePath[0])
 	{
-		return false;
+		return MediaLoadStatus::Failed;
 	}
 
 	const std::string path = overridePath;
 	const std::string filename = Utils::FilenameFromPath(path);
 	if (
 		areaMusicOverrideBuffer
-		&& !areaMusicOverrideBuffer->bytes.empty()
+		&& areaMusicOverrideBuffer->Size() != 0
 		&& areaMusicOverrideBuffer->path == path
 		)
 	{
-		return true;
+		return MediaLoadStatus::Ready;
+	}
+
+	auto matchesPath = [&path](const std::unique_ptr<AreaMusicManagerBuffer>& buffer)
+	{
+		return buffer
+			&& buffer->Size() != 0
+			&& buffer->path == path;
+	};
+
+	// Decoding runs on the decode service. Until it finishes, the current override stays registered and the
+	// caller is asked to try again on a later frame.
+	AudioDecodeService::Result decoded{};
+	const bool hasRetiredBuffer = std::any_of(
+		retiredAreaMusicManagerBuffers.begin(),
+		retiredAreaMusicManagerBuffers.end(),
+		matchesPath
+	);
+	if (!hasRetiredBuffer)
+	{
+		if (pendingOverrideDecode && pendingOverrideDecode->Path() != path)
+		{
+			pendingOverrideDecode->Cancel();
+			pendingOverrideDecode.reset();
+		}
+		if (!pendingOverrideDecode)
+		{
+			pendingOverrideDecode = AudioDecodeService::GetInstance().Queue(
+				path,
+				AudioDecodeService::Priority::Playback,
+				encoding
+			);
+			Logging::Write(logPrefix, "Queued custom audio override for decoding: \"%s\"", filename.c_str());
+		}
+		if (!pendingOverrideDecode->IsReady())
+		{
+			return MediaLoadStatus::Pending;
+		}
+
+		decoded = pendingOverrideDecode->Take();
+		pendingOverrideDecode.reset();
+		if (!decoded.success)
+		{
+			Logging::Write(logPrefix, "Failed to load custom audio override as Wwise media: \"%s\"", filename.c_str());
+			return MediaLoadStatus::Failed;
+		}
 	}
 
 	if (areaMusicOverrideRegistered)
@@ -1290,12 +1353,7 @@ bool AreaMusicManager::LoadAreaMusicManager(const char* overridePath)
 	auto retiredIt = std::find_if(
 		retiredAreaMusicManagerBuffers.begin(),
 		retiredAreaMusicManagerBuffers.end(),
-		[&path](const std::unique_ptr<AreaMusicManagerBuffer>& buffer)
-		{
-			return buffer
-				&& !buffer->bytes.empty()
-				&& buffer->path == path;
-		}
+		matchesPath
 	);
 	if (retiredIt != retiredAreaMusicManagerBuffers.end())
 	{
@@ -1304,33 +1362,101 @@ bool AreaMusicManager::LoadAreaMusicManager(const char* overridePath)
 		Logging::Write(logPrefix,
 			"Reusing retired area music audio buffer for \"%s\" (%zu bytes, source plugin 0x%08x, duration %lld ms)",
 			filename.c_str(),
-			areaMusicOverrideBuffer->bytes.size(),
+			areaMusicOverrideBuffer->Size(),
 			areaMusicOverrideBuffer->sourcePluginId,
 			areaMusicOverrideBuffer->durationMs
 		);
-		return true;
-	}
-
-	AudioDecoder::WwiseMediaBuffer media{};
-	if (!AudioDecoder::LoadWwiseMedia(path, media))
-	{
-		Logging::Write(logPrefix, "Failed to load custom audio override as Wwise media: \"%s\"", filename.c_str());
-		return false;
+		return MediaLoadStatus::Ready;
 	}
 
+	AudioDecoder::WwiseMediaBuffer& media = decoded.media;
 	areaMusicOverrideBuffer = std::make_unique<AreaMusicManagerBuffer>();
 	areaMusicOverrideBuffer->path = path;
 	areaMusicOverrideBuffer->bytes = std::move(media.bytes);
+	areaMusicOverrideBuffer->mappedFile = std::move(media.mappedFile);
+	areaMusicOverrideBuffer->mappedBytes = media.mappedBytes;
+	areaMusicOverrideBuffer->mappedSize = media.mappedSize;
 	areaMusicOverrideBuffer->sourcePluginId = media.sourcePluginId;
 	areaMusicOverrideBuffer->durationMs = media.durationMs;
 	Logging::Write(logPrefix,
 		"Loaded area music audio override from \"%s\" (%zu bytes, source plugin 0x%08x, duration %lld ms)",
 		filename.c_str(),
-		areaMusicOverrideBuffer->bytes.size(),
+		areaMusicOverrideBuffer->Size(),
 		areaMusicOverrideBuffer->sourcePluginId,
 		areaMusicOverrideBuffer->durationMs
 	);
-	return true;
+	return MediaLoadStatus::Ready;
+}
+
+void AreaMusicManager::PreloadInternalWwiseArchive()
+{
+	std::vector<const MusicData*> internalSongs;
+	for (const std::string& name : ModConfiguration::activePlaylist)
+	{
+		auto it = ModConfiguration::Databases::songDatabase.find(name);
+		if (
+			it != ModConfiguration::Databases::songDatabase.end()
+			&& it->second.internalWwiseAreaTrack.sourceId != 0
+		)
+		{
+			internalSongs.push_back(&it->second);
+		}
+	}
+	if (internalSongs.empty())
+	{
+		return;
+	}
+
+	std::string error;
+	if (!DecimaArchiveReader::LoadArchiveIndex(error))
+	{
+		Logging::Write(logPrefix, "Failed to index Decima archives for internal Wwise media: %s", error.c_str());
+		return;
+	}
+	Logging::Write(logPrefix, "Indexed Decima archives for internal Wwise media");
+
+	// Only the RIFF header of each stream is decoded, so a bad table entry shows up now instead of mid-game.
+	std::vector<DecimaArchiveReader::ReadFileRequest> requests(internalSongs.size());
+	for (size_t i = 0; i < internalSongs.size(); i++)
+	{
+		const InternalWwiseAreaTrackData& internalAreaTrack = internalSongs[i]->internalWwiseAreaTrack;
+		requests[i].pathHash = GetStreamPathHash(internalAreaTrack);
+		requests[i].expectedSize = internalAreaTrack.streamMediaSize;
+		requests[i].rangeLength = (std::min)(internalWwiseHeaderProbeSize, internalAreaTrack.streamMediaSize);
+	}
+	DecimaArchiveReader::ReadArchiveFiles(requests);
+
+	size_t invalidCount = 0;
+	for (size_t i = 0; i < internalSongs.size(); i++)
+	{
+		const MusicData* data = internalSongs[i];
+		const DecimaArchiveReader::ReadFileRequest& request = requests[i];
+		const std::vector<uint8_t>& header = request.output;
+		const bool riffSizeMatches = header.size() >= 8
+			&& Utils::ReadLe32(header.data() + 4) + 8ull == data->internalWwiseAreaTrack.streamMediaSize;
+		if (!request.result.success)
+		{
+			invalidCount++;
+			Logging::Write(logPrefix,
+				"Internal Wwise media for \"%s\" is not readable: %s",
+				data->name ? data->name : "",
+				request.result.error.c_str()
+			);
+		}
+		else if (!LooksLikeWwiseMediaBuffer(header.data(), header.size()) || !riffSizeMatches)
+		{
+			invalidCount++;
+			Logging::Write(logPrefix,
+				"Internal Wwise media for \"%s\" does not start with a matching RIFF header",
+				data->name ? data->name : ""
+			);
+		}
+	}
+	Logging::Write(logPrefix,
+		"Validated %zu internal Wwise streams (%zu invalid)",
+		internalSongs.size(),
+		invalidCount
+	);
 }
 
 bool AreaMusicManager::LoadInternalWwiseMediaFromGameArchive(
@@ -1353,19 +1479,45 @@ bool AreaMusicManager::LoadInternalWwiseMediaFromGameArchive(
 		return false;
 	}
 
-	const std::string streamPath = DecimaArchiveReader::BuildStreamedWemPath(internalAreaTrack.sourceId);
+	const uint64_t streamPathHash = GetStreamPathHash(internalAreaTrack);
+
+	// A previous session's extraction is reused as long as the pack serving the stream is unchanged.
+	std::string stampError;
+	DecimaArchiveReader::ArchiveFileStamp stamp{};
+	const bool hasStamp = DecimaArchiveReader::GetArchiveFileStamp(streamPathHash, stamp, stampError)
+		&& stamp.size == internalAreaTrack.streamMediaSize;
+	const MediaCache::InternalMediaKey cacheKey{
+		internalAreaTrack.sourceId,
+		internalAreaTrack.streamMediaSize,
+		stamp.packSize,
+		stamp.packLastWriteTime
+	};
+
 	std::vector<uint8_t> mediaBytes;
-	const DecimaArchiveReader::ReadFileResult readResult =
-		DecimaArchiveReader::ReadInitialArchiveFile(
-			streamPath,
+	DecimaArchiveReader::ReadFileResult readResult{};
+	bool fromCache = false;
+	if (
+		hasStamp
+		&& MediaCache::LoadInternalMedia(cacheKey, mediaBytes)
+		&& LooksLikeWwiseMediaBuffer(mediaBytes.data(), mediaBytes.size())
+	)
+	{
+		readResult = { true, {}, mediaBytes.size() };
+		fromCache = true;
+	}
+	else
+	{
+		readResult = DecimaArchiveReader::ReadArchiveFile(
+			streamPathHash,
 			internalAreaTrack.streamMediaSize,
 			mediaBytes
 		);
+	}
 	if (!readResult.success)
 	{
 		Logging::Write(logPrefix,
-			"Failed to extract Decima stream \"%s\" for internal Wwise media \"%s\": %s",
-			streamPath.c_str(),
+			"Failed to extract Decima stream %u.core.stream for internal Wwise media \"%s\": %s",
+			internalAreaTrack.sourceId,
 			data->name ? data->name : "",
 			readResult.error.c_str()
 		);
@@ -1376,8 +1528,8 @@ bool AreaMusicManager::LoadInternalWwiseMediaFromGameArchive(
 	if (!LooksLikeWwiseMediaBuffer(mediaBytes.data(), mediaBytes.size()))
 	{
 		Logging::Write(logPrefix,
-			"Extracted Decima stream \"%s\" for \"%s\" is not valid Wwise media (%zu/%zu bytes)",
-			streamPath.c_str(),
+			"Extracted Decima stream %u.core.stream for \"%s\" is not valid Wwise media (%zu/%zu bytes)",
+			internalAreaTrack.sourceId,
 			data->name ? data->name : "",
 			readResult.copiedBytes,
 			mediaBytes.size()
@@ -1386,6 +1538,14 @@ bool AreaMusicManager::LoadInternalWwiseMediaFromGameArchive(
 		return false;
 	}
 
+	if (hasStamp && !fromCache && !MediaCache::StoreInternalMedia(cacheKey, mediaBytes))
+	{
+		Logging::Write(logPrefix,
+			"Could not cache internal Wwise media for \"%s\"",
+			data->name ? data->name : ""
+		);
+	}
+
 	output = {};
 	output.path = "internal-wwise:" + std::to_string(internalAreaTrack.sourceId);
 	output.bytes = std::move(mediaBytes);
@@ -1395,14 +1555,28 @@ bool AreaMusicManager::LoadInternalWwiseMediaFromGameArchive(
 	output.durationMs = data->maxLength;
 
 	Logging::Write(logPrefix,
-		"Extracted internal Wwise media for \"%s\" from Decima stream \"%s\" "
+		"%s internal Wwise media for \"%s\" from Decima stream %u.core.stream "
 		"(%zu bytes, source plugin 0x%08x, duration %lld ms)",
+		fromCache ? "Loaded cached" : "Extracted",
 		data->name ? data->name : "",
-		streamPath.c_str(),
+		internalAreaTrack.sourceId,
 		output.bytes.size(),
 		output.sourcePluginId,
 		output.durationMs
 	);
+
+	if (ModConfiguration::devMode)
+	{
+		const DecimaArchiveReader::ChunkCacheStats cacheStats = DecimaArchiveReader::GetChunkCacheStats();
+		Logging::Write(logPrefix,
+			"Decima chunk cache: %llu hits, %llu misses, %llu evictions, %zu/%zu bytes",
+			cacheStats.hits,
+			cacheStats.misses,
+			cacheStats.evictions,
+			cacheStats.cachedBytes,
+			cacheStats.budgetBytes
+		);
+	}
 	return true;
 }
 
@@ -1417,7 +1591,7 @@ bool AreaMusicManager::LoadInternalWwiseMedia(const MusicData* data)
 	const std::string path = "internal-wwise:" + std::to_string(internalAreaTrack.sourceId);
 	if (
 		areaMusicOverrideBuffer
-		&& !areaMusicOverrideBuffer->bytes.empty()
+		&& areaMusicOverrideBuffer->Size() != 0
 		&& areaMusicOverrideBuffer->path == path
 	)
 	{
@@ -1436,7 +1610,7 @@ bool AreaMusicManager::LoadInternalWwiseMedia(const MusicData* data)
 		[&path](const std::unique_ptr<AreaMusicManagerBuffer>& buffer)
 		{
 			return buffer
-				&& !buffer->bytes.empty()
+				&& buffer->Size() != 0
 				&& buffer->path == path;
 		}
 	);
@@ -1447,7 +1621,7 @@ bool AreaMusicManager::LoadInternalWwiseMedia(const MusicData* data)
 		Logging::Write(logPrefix,
 			"Reusing cloned internal Wwise area override for \"%s\" (%zu bytes, source plugin 0x%08x, duration %lld ms)",
 			data->name ? data->name : "",
-			areaMusicOverrideBuffer->bytes.size(),
+			areaMusicOverrideBuffer->Size(),
 			areaMusicOverrideBuffer->sourcePluginId,
 			areaMusicOverrideBuffer->durationMs
 		);
@@ -1474,7 +1648,7 @@ bool AreaMusicManager::LoadInternalWwiseMedia(const MusicData* data)
 		"(%zu bytes, target source %u, source plugin 0x%08x, duration %lld ms)",
 		data->name ? data->name : "",
 		internalAreaTrack.sourceId,
-		areaMusicOverrideBuffer->bytes.size(),
+		areaMusicOverrideBuffer->Size(),
 		AreaMusic::OverrideTarget.sourceId,
 		areaMusicOverrideBuffer->sourcePluginId,
 		areaMusicOverrideBuffer->durationMs
@@ -1486,6 +1660,7 @@ void AreaMusicManager::HandleRegisterRequest(AreaMusic::RegisterRequest& request
 {
 	request.handled = true;
 	request.success = false;
+	request.pending = false;
 	request.metadataPatched = false;
 	request.effectiveDurationMs = request.data ? request.data->maxLength : 0;
 	request.effectiveSourceStartMs = 0;
@@ -1534,7 +1709,21 @@ void AreaMusicManager::HandleRegisterRequest(AreaMusic::RegisterRequest& request
 	else if (customMediaOverride)
 	{
 		const char* overridePath = data ? data->customWemPath : nullptr;
-		if (!ResolveWwiseMediaFunctions() || !LoadAreaMusicManager(overridePath))
+		if (!ResolveWwiseMediaFunctions())
+		{
+			return;
+		}
+
+		const AudioDecoder::OutputEncoding encoding = data && data->compressCustomAudio
+			? AudioDecoder::OutputEncoding::ImaAdpcm
+			: AudioDecoder::OutputEncoding::Pcm;
+		const MediaLoadStatus loadStatus = LoadAreaMusicManager(overridePath, encoding);
+		if (loadStatus == MediaLoadStatus::Pending)
+		{
+			request.pending = true;
+			return;
+		}
+		if (loadStatus != MediaLoadStatus::Ready)
 		{
 			return;
 		}
@@ -1545,7 +1734,7 @@ void AreaMusicManager::HandleRegisterRequest(AreaMusic::RegisterRequest& request
 	}
 
 	const uint32_t sourceId = AreaMusic::OverrideTarget.sourceId;
-	if (!areaMusicOverrideBuffer || areaMusicOverrideBuffer->bytes.empty())
+	if (!areaMusicOverrideBuffer || areaMusicOverrideBuffer->Size() == 0)
 	{
 		return;
 	}
@@ -1578,7 +1767,7 @@ void AreaMusicManager::HandleRegisterRequest(AreaMusic::RegisterRequest& request
 		Logging::Write(logPrefix,
 			"Area00 live metadata patch failed for \"%s\" (media %zu bytes, source plugin 0x%08x, duration %lld ms, source start %lld ms)",
 			data ? data->name : "",
-			areaMusicOverrideBuffer->bytes.size(),
+			areaMusicOverrideBuffer->Size(),
 			areaMusicOverrideBuffer->sourcePluginId,
 			sourceDurationMs,
 			sourceStartMs
@@ -1593,7 +1782,7 @@ void AreaMusicManager::HandleRegisterRequest(AreaMusic::RegisterRequest& request
 		"Area00 live metadata patch applied for \"%s\" "
 		"(media %zu bytes, source plugin 0x%08x, duration %lld ms, source start %lld ms)",
 		data ? data->name : "",
-		areaMusicOverrideBuffer->bytes.size(),
+		areaMusicOverrideBuffer->Size(),
 		areaMusicOverrideBuffer->sourcePluginId,
 		sourceDurationMs,
 		sourceStartMs
@@ -1607,8 +1796,9 @@ void AreaMusicManager::HandleRegisterRequest(AreaMusic::RegisterRequest& request
 
 	AkSourceSettings media{};
 	media.sourceId = sourceId;
-	media.mediaMemory = areaMusicOverrideBuffer->bytes.data();
-	media.mediaSize = static_cast<uint32_t>(areaMusicOverrideBuffer->bytes.size());
+	// Cached media is mapped copy-on-write, so handing Wwise a writable pointer to it is safe.
+	media.mediaMemory = const_cast<uint8_t*>(areaMusicOverrideBuffer->Data());
+	media.mediaSize = static_cast<uint32_t>(areaMusicOverrideBuffer->Size());
 
 	uint32_t result = setMediaFunc(&media, 1);
 	if (!result)
@@ -1660,10 +1850,10 @@ void AreaMusicManager::Unset()
 	media.sourceId = areaMusicOverrideRegisteredMediaId
 		? areaMusicOverrideRegisteredMediaId
 		: AreaMusic::OverrideTarget.sourceId;
-	if (areaMusicOverrideBuffer && !areaMusicOverrideBuffer->bytes.empty())
+	if (areaMusicOverrideBuffer && areaMusicOverrideBuffer->Size() != 0)
 	{
-		media.mediaMemory = areaMusicOverrideBuffer->bytes.data();
-		media.mediaSize = static_cast<uint32_t>(areaMusicOverrideBuffer->bytes.size());
+		media.mediaMemory = const_cast<uint8_t*>(areaMusicOverrideBuffer->Data());
+		media.mediaSize = static_cast<uint32_t>(areaMusicOverrideBuffer->Size());
 	}
 
 	uint32_t result = unsetMediaFunc(&media, 1);
@@ -1686,7 +1876,7 @@ void AreaMusicManager::Unset()
 
 void AreaMusicManager::RetireBuffer()
 {
-	if (!areaMusicOverrideBuffer || areaMusicOverrideBuffer->bytes.empty())
+	if (!areaMusicOverrideBuffer || areaMusicOverrideBuffer->Size() == 0)
 	{
 		return;
 	}
@@ -1694,7 +1884,7 @@ void AreaMusicManager::RetireBuffer()
 	Logging::Write(logPrefix,
 		"Keeping retired area music audio buffer alive for \"%s\" (%zu bytes)",
 		filename.c_str(),
-		areaMusicOverrideBuffer->bytes.size()
+		areaMusicOverrideBuffer->Size()
 	);
 	retiredAreaMusicManagerBuffers.push_back(std::move(areaMusicOverrideBuffer));
 }
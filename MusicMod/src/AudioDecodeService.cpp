@@ -0,0 +1,172 @@
+#include "AudioDecodeService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include "Logger.h"
+#include "MediaCache.h"
+#include "ModConfiguration.h"
+#include "Utils.h"
+
+bool AudioDecodeService::Job::IsReady() const
+{
+	return future_.valid() && future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+AudioDecodeService::Result AudioDecodeService::Job::Take()
+{
+	return future_.valid() ? future_.get() : Result{};
+}
+
+AudioDecodeService& AudioDecodeService::GetInstance()
+{
+	// Never destroyed: the workers are detached and may still be decoding while the process exits.
+	static AudioDecodeService* instance = new AudioDecodeService();
+	return *instance;
+}
+
+std::shared_ptr<AudioDecodeService::Job> AudioDecodeService::Queue(
+	const std::string& path,
+	Priority priority,
+	AudioDecoder::OutputEncoding encoding,
+	Callback callback
+)
+{
+	auto job = std::make_shared<Job>();
+	job->path_ = path;
+	job->priority_ = priority;
+	job->encoding_ = encoding;
+	job->callback_ = std::move(callback);
+	job->future_ = job->promise_.get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job->sequence_ = nextSequence_++;
+		queue_.push_back(job);
+		StartWorkers();
+	}
+	wake_.notify_one();
+	return job;
+}
+
+// Caller must hold mutex_.
+void AudioDecodeService::StartWorkers()
+{
+	if (workersStarted_)
+	{
+		return;
+	}
+
+	workersStarted_ = true;
+	for (size_t i = 0; i < workerCount; i++)
+	{
+		std::thread(&AudioDecodeService::WorkerLoop, this).detach();
+	}
+	Logging::Write(logPrefix, "Started %zu audio decode workers", workerCount);
+}
+
+// Caller must hold mutex_.
+std::shared_ptr<AudioDecodeService::Job> AudioDecodeService::PopNextJob()
+{
+	auto next = std::min_element(
+		queue_.begin(),
+		queue_.end(),
+		[](const std::shared_ptr<Job>& lhs, const std::shared_ptr<Job>& rhs)
+		{
+			if (lhs->priority_ != rhs->priority_)
+			{
+				return lhs->priority_ > rhs->priority_;
+			}
+			return lhs->sequence_ < rhs->sequence_;
+		}
+	);
+	if (next == queue_.end())
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<Job> job = std::move(*next);
+	queue_.erase(next);
+	return job;
+}
+
+void AudioDecodeService::Complete(Job& job, Result&& result)
+{
+	if (job.callback_)
+	{
+		job.callback_(job.path_, result);
+	}
+	job.promise_.set_value(std::move(result));
+}
+
+void AudioDecodeService::WorkerLoop()
+{
+	for (;;)
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [this]() { return !queue_.empty(); });
+			job = PopNextJob();
+		}
+		if (!job)
+		{
+			continue;
+		}
+
+		Result result{};
+		const std::string filename = Utils::FilenameFromPath(job->path_);
+		// An entry left over from before the song's output encoding changed is decoded again and replaced.
+		if (
+			!job->IsCanceled()
+			&& MediaCache::LoadTranscodedMedia(job->path_, result.media)
+			&& result.media.sourcePluginId == AudioDecoder::GetSourcePluginId(job->encoding_)
+		)
+		{
+			result.success = true;
+			Logging::Write(logPrefix,
+				"Mapped cached decode of \"%s\" (%zu bytes)",
+				filename.c_str(),
+				result.media.Size()
+			);
+		}
+		else if (!job->IsCanceled())
+		{
+			const auto start = std::chrono::steady_clock::now();
+			result.success = AudioDecoder::LoadWwiseMedia(
+				job->path_,
+				result.media,
+				&job->canceled_,
+				job->encoding_
+			);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			Logging::Write(logPrefix,
+				"%s \"%s\" in %.0f ms",
+				result.success ? "Decoded" : (job->IsCanceled() ? "Canceled decode of" : "Failed to decode"),
+				filename.c_str(),
+				elapsed.count()
+			);
+
+			// Only real decodes are worth caching; native WEM files are already served straight from disk.
+			if (
+				result.success
+				&& result.media.decodedToPcm
+				&& ModConfiguration::transcodeCacheSizeMB != 0
+				&& !job->IsCanceled()
+				&& !MediaCache::StoreTranscodedMedia(job->path_, result.media)
+			)
+			{
+				Logging::Write(logPrefix, "Could not cache decode of \"%s\"", filename.c_str());
+			}
+		}
+		result.canceled = job->IsCanceled();
+		if (result.canceled)
+		{
+			result.success = false;
+			result.media = {};
+		}
+		Complete(*job, std::move(result));
+	}
+}
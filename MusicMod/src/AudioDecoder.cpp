@@ -1,5 +1,7 @@
 #include "AudioDecoder.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <filesystem>
 #include <limits>
@@ -17,16 +19,24 @@
 #pragma comment(lib, "mfuuid.lib")
 #pragma comment(lib, "ole32.lib")
 
+#include "FlacDecoder.h"
+#include "ImaAdpcmEncoder.h"
 #include "Logger.h"
+#include "MappedFile.h"
+#include "PcmFileParser.h"
+#include "SimdKernels.h"
 #include "Utils.h"
 
 namespace
 {
 	constexpr const char* logPrefix = "Audio Decoder";
 	constexpr uint32_t wwisePcmSourcePluginId = 0x00010001;
+	constexpr uint32_t wwiseAdpcmSourcePluginId = 0x00020001;
 	constexpr uint32_t wwiseVorbisSourcePluginId = 0x00040001;
 	constexpr uint32_t pcmWemRiffSizeWithoutData = 60;
 	constexpr size_t pcmWemHeaderSize = 68;
+	constexpr size_t adpcmWemHeaderSize = 52;
+	constexpr uint16_t waveFormatImaAdpcm = 0x0002;
 	constexpr size_t maxPcmByteCount =
 		static_cast<size_t>((std::numeric_limits<uint32_t>::max)() - pcmWemRiffSizeWithoutData);
 
@@ -64,6 +74,15 @@ namespace
 		".wv"
 	};
 
+	// Containers that may hold samples Wwise can play without decoding; see PcmFileParser.
+	constexpr std::string_view pcmFileExtensions[] = {
+		".wav",
+		".wave",
+		".aif",
+		".aiff",
+		".aifc"
+	};
+
 	template<typename T>
 	struct ComReleaser
 	{
@@ -333,6 +352,57 @@ namespace
 		return durationMs > 0;
 	}
 
+	bool TryReadImaAdpcmWaveDuration(
+		const std::vector<uint8_t>& bytes,
+		long long& durationMs,
+		uint32_t& channels,
+		uint32_t& sampleRate
+	)
+	{
+		durationMs = 0;
+		channels = 0;
+		sampleRate = 0;
+
+		uint16_t formatTag = 0;
+		uint32_t blockAlign = 0;
+		uint32_t dataSize = 0;
+		if (!ForEachWaveChunk(bytes,
+			[&](const WaveChunk& chunk)
+			{
+				if (IsChunkId(bytes, chunk, "fmt ") && chunk.dataSize >= 16)
+				{
+					formatTag = Utils::ReadLe16FromBytes(bytes, chunk.dataOffset);
+					channels = Utils::ReadLe16FromBytes(bytes, chunk.dataOffset + 2);
+					sampleRate = Utils::ReadLe32FromBytes(bytes, chunk.dataOffset + 4);
+					blockAlign = Utils::ReadLe16FromBytes(bytes, chunk.dataOffset + 12);
+				}
+				else if (IsChunkId(bytes, chunk, "data"))
+				{
+					dataSize = chunk.dataSize;
+				}
+
+				return true;
+			}
+		))
+		{
+			return false;
+		}
+
+		if (
+			formatTag != waveFormatImaAdpcm
+			|| channels == 0
+			|| sampleRate == 0
+			|| blockAlign != ImaAdpcmEncoder::bytesPerChannelBlock * channels
+		)
+		{
+			return false;
+		}
+
+		const uint64_t sampleCount = static_cast<uint64_t>(dataSize / blockAlign) * ImaAdpcmEncoder::samplesPerBlock;
+		durationMs = static_cast<long long>((sampleCount * 1000ULL) / sampleRate);
+		return durationMs > 0;
+	}
+
 	bool TryReadWwiseVorbisDuration(
 		const std::vector<uint8_t>& bytes,
 		long long& durationMs,
@@ -385,39 +455,30 @@ namespace
 		return found;
 	}
 
-	bool BuildPcmWemBytes(
-		const std::vector<uint8_t>& pcmBytes,
-		uint32_t channels,
-		uint32_t sampleRate,
-		uint32_t bitsPerSample,
-		std::vector<uint8_t>& wemBytes
-	)
+	bool IsValidPcmFormat(uint32_t channels, uint32_t sampleRate, uint32_t bitsPerSample)
 	{
-		if (
-			pcmBytes.empty()
-			|| channels == 0
-			|| sampleRate == 0
-			|| bitsPerSample == 0
-			|| bitsPerSample % 8 != 0
-			|| pcmBytes.size() > maxPcmByteCount
-		)
+		if (channels == 0 || sampleRate == 0 || bitsPerSample == 0 || bitsPerSample % 8 != 0)
 		{
 			return false;
 		}
 
 		const uint64_t blockAlign = static_cast<uint64_t>(channels) * (bitsPerSample / 8);
 		const uint64_t byteRate = blockAlign * sampleRate;
-		if (
-			blockAlign == 0
-			|| blockAlign > (std::numeric_limits<uint16_t>::max)()
-			|| byteRate > (std::numeric_limits<uint32_t>::max)()
-		)
-		{
-			return false;
-		}
+		return blockAlign <= (std::numeric_limits<uint16_t>::max)()
+			&& byteRate <= (std::numeric_limits<uint32_t>::max)();
+	}
 
-		const uint32_t dataSize = static_cast<uint32_t>(pcmBytes.size());
-		const uint32_t riffSize = pcmWemRiffSizeWithoutData + dataSize;
+	void WritePcmWemHeader(
+		uint8_t* header,
+		uint32_t channels,
+		uint32_t sampleRate,
+		uint32_t bitsPerSample,
+		uint32_t dataSize,
+		uint32_t channelMask
+	)
+	{
+		const uint32_t blockAlign = channels * (bitsPerSample / 8);
+		const uint32_t byteRate = blockAlign * sampleRate;
 		const uint8_t pcmSubFormatGuid[16] = {
 			0x01, 0x00, 0x00, 0x00,
 			0x00, 0x00,
@@ -426,50 +487,281 @@ namespace
 			0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
 		};
 
-		wemBytes.clear();
-		wemBytes.reserve(pcmWemHeaderSize + pcmBytes.size());
-		wemBytes.insert(wemBytes.end(), { 'R', 'I', 'F', 'F' });
-		Utils::AppendLe32(wemBytes, riffSize);
-		wemBytes.insert(wemBytes.end(), { 'W', 'A', 'V', 'E' });
-		wemBytes.insert(wemBytes.end(), { 'f', 'm', 't', ' ' });
-		Utils::AppendLe32(wemBytes, 40);
-		Utils::AppendLe16(wemBytes, 0xfffe);
-		Utils::AppendLe16(wemBytes, static_cast<uint16_t>(channels));
-		Utils::AppendLe32(wemBytes, sampleRate);
-		Utils::AppendLe32(wemBytes, static_cast<uint32_t>(byteRate));
-		Utils::AppendLe16(wemBytes, static_cast<uint16_t>(blockAlign));
-		Utils::AppendLe16(wemBytes, static_cast<uint16_t>(bitsPerSample));
-		Utils::AppendLe16(wemBytes, 22);
-		Utils::AppendLe16(wemBytes, static_cast<uint16_t>(bitsPerSample));
-		Utils::AppendLe32(wemBytes, GetDefaultChannelMask(channels));
-		wemBytes.insert(
-			wemBytes.end(),
-			pcmSubFormatGuid,
-			pcmSubFormatGuid + sizeof(pcmSubFormatGuid)
+		std::memcpy(header, "RIFF", 4);
+		Utils::WriteLe32(header + 4, pcmWemRiffSizeWithoutData + dataSize);
+		std::memcpy(header + 8, "WAVEfmt ", 8);
+		Utils::WriteLe32(header + 16, 40);
+		Utils::WriteLe16(header + 20, 0xfffe);
+		Utils::WriteLe16(header + 22, static_cast<uint16_t>(channels));
+		Utils::WriteLe32(header + 24, sampleRate);
+		Utils::WriteLe32(header + 28, byteRate);
+		Utils::WriteLe16(header + 32, static_cast<uint16_t>(blockAlign));
+		Utils::WriteLe16(header + 34, static_cast<uint16_t>(bitsPerSample));
+		Utils::WriteLe16(header + 36, 22);
+		Utils::WriteLe16(header + 38, static_cast<uint16_t>(bitsPerSample));
+		Utils::WriteLe32(header + 40, channelMask != 0 ? channelMask : GetDefaultChannelMask(channels));
+		std::memcpy(header + 44, pcmSubFormatGuid, sizeof(pcmSubFormatGuid));
+		std::memcpy(header + 60, "data", 4);
+		Utils::WriteLe32(header + 64, dataSize);
+	}
+
+	// Wwise's ADPCM media is a plain WAVEFORMATEX with a 6-byte extension: samples per block, then the channel mask.
+	void WriteAdpcmWemHeader(
+		uint8_t* header,
+		uint32_t channels,
+		uint32_t sampleRate,
+		uint32_t dataSize,
+		uint32_t channelMask
+	)
+	{
+		const uint32_t blockAlign = ImaAdpcmEncoder::bytesPerChannelBlock * channels;
+		const uint32_t byteRate = static_cast<uint32_t>(
+			static_cast<uint64_t>(sampleRate) * blockAlign / ImaAdpcmEncoder::samplesPerBlock
 		);
-		wemBytes.insert(wemBytes.end(), { 'd', 'a', 't', 'a' });
-		Utils::AppendLe32(wemBytes, dataSize);
-		wemBytes.insert(wemBytes.end(), pcmBytes.begin(), pcmBytes.end());
-		return true;
+
+		std::memcpy(header, "RIFF", 4);
+		Utils::WriteLe32(header + 4, static_cast<uint32_t>(adpcmWemHeaderSize - 8) + dataSize);
+		std::memcpy(header + 8, "WAVEfmt ", 8);
+		Utils::WriteLe32(header + 16, 24);
+		Utils::WriteLe16(header + 20, waveFormatImaAdpcm);
+		Utils::WriteLe16(header + 22, static_cast<uint16_t>(channels));
+		Utils::WriteLe32(header + 24, sampleRate);
+		Utils::WriteLe32(header + 28, byteRate);
+		Utils::WriteLe16(header + 32, static_cast<uint16_t>(blockAlign));
+		Utils::WriteLe16(header + 34, 4);
+		Utils::WriteLe16(header + 36, 6);
+		Utils::WriteLe16(header + 38, static_cast<uint16_t>(ImaAdpcmEncoder::samplesPerBlock));
+		Utils::WriteLe32(header + 40, channelMask != 0 ? channelMask : GetDefaultChannelMask(channels));
+		std::memcpy(header + 44, "data", 4);
+		Utils::WriteLe32(header + 48, dataSize);
+	}
+
+	// Folds a layout wider than stereo into stereo: left and right speakers keep their side, centers go to both at
+	// -3 dB, surrounds to their side at -3 dB and LFE is dropped. The gains are then scaled down until a full-scale
+	// signal on every channel cannot clip.
+	void GetStereoDownmixCoefficients(uint32_t channels, uint32_t channelMask, float* coefficients)
+	{
+		constexpr float halfPower = 0.70710678f;
+		float* left = coefficients;
+		float* right = coefficients + channels;
+		uint32_t remainingMask = channelMask != 0 ? channelMask : GetDefaultChannelMask(channels);
+		for (uint32_t channel = 0; channel < channels; channel++)
+		{
+			// WAVE stores channels in the order of their speaker bits; channels past the mask have no position.
+			const uint32_t speaker = remainingMask & (0u - remainingMask);
+			remainingMask &= remainingMask - 1;
+			switch (speaker)
+			{
+				case 0x1: case 0x40:
+					left[channel] = 1.0f;
+					right[channel] = 0.0f;
+					break;
+				case 0x2: case 0x80:
+					left[channel] = 0.0f;
+					right[channel] = 1.0f;
+					break;
+				case 0x8:
+					left[channel] = 0.0f;
+					right[channel] = 0.0f;
+					break;
+				case 0x10: case 0x200:
+					left[channel] = halfPower;
+					right[channel] = 0.0f;
+					break;
+				case 0x20: case 0x400:
+					left[channel] = 0.0f;
+					right[channel] = halfPower;
+					break;
+				default:
+					left[channel] = halfPower;
+					right[channel] = halfPower;
+					break;
+			}
+		}
+
+		float leftSum = 0.0f;
+		float rightSum = 0.0f;
+		for (uint32_t channel = 0; channel < channels; channel++)
+		{
+			leftSum += left[channel];
+			rightSum += right[channel];
+		}
+		const float loudestSum = (std::max)(leftSum, rightSum);
+		if (loudestSum > 1.0f)
+		{
+			for (uint32_t channel = 0; channel < channels * 2; channel++)
+			{
+				coefficients[channel] /= loudestSum;
+			}
+		}
+	}
+
+	enum class SampleFormat
+	{
+		Int16,
+		Int24,
+		Int32,
+		Float32
+	};
+
+	// Turns decoded samples into the 16-bit PCM Wwise plays: wider samples are dithered down and layouts wider than
+	// stereo are folded to stereo. Works through cache-sized chunks, so each decoded buffer is only read once.
+	class PcmConverter
+	{
+	public:
+		PcmConverter(SampleFormat format, uint32_t channels, uint32_t channelMask)
+			: format_(format), channels_(channels)
+		{
+			downmix_ = channels > 2 && channels <= SimdKernels::maxDownmixChannels;
+			outputChannels_ = downmix_ ? 2 : channels;
+			if (downmix_)
+			{
+				GetStereoDownmixCoefficients(channels, channelMask, coefficients_);
+			}
+		}
+
+		// Layouts wider than maxDownmixChannels can only be passed through, which 16-bit input allows.
+		bool IsSupported() const { return channels_ != 0 && (downmix_ || channels_ <= 2); }
+		bool NeedsConversion() const { return format_ != SampleFormat::Int16 || downmix_; }
+		uint32_t OutputChannels() const { return outputChannels_; }
+
+		size_t SourceFrameSize() const
+		{
+			switch (format_)
+			{
+				case SampleFormat::Int16: return channels_ * 2u;
+				case SampleFormat::Int24: return channels_ * 3u;
+				default: return channels_ * 4u;
+			}
+		}
+
+		// Writes frames * OutputChannels() samples. target may be source itself, since a frame never grows.
+		void Convert(const uint8_t* source, size_t frames, uint8_t* target)
+		{
+			if (!NeedsConversion())
+			{
+				std::memmove(target, source, frames * SourceFrameSize());
+				return;
+			}
+
+			constexpr size_t chunkFrames = 1024;
+			widened_.resize(chunkFrames * channels_);
+			mixed_.resize(chunkFrames * 2);
+			for (size_t done = 0; done < frames;)
+			{
+				const size_t count = (std::min)(chunkFrames, frames - done);
+				const uint8_t* chunk = source + done * SourceFrameSize();
+				const size_t sampleCount = count * channels_;
+				switch (format_)
+				{
+					case SampleFormat::Int16:
+						SimdKernels::Int16ToFloat(chunk, widened_.data(), sampleCount);
+						break;
+					case SampleFormat::Int24:
+						SimdKernels::Int24ToFloat(chunk, widened_.data(), sampleCount);
+						break;
+					case SampleFormat::Int32:
+						SimdKernels::Int32ToFloat(chunk, widened_.data(), sampleCount);
+						break;
+					case SampleFormat::Float32:
+						std::memcpy(widened_.data(), chunk, sampleCount * sizeof(float));
+						break;
+				}
+
+				const float* samples = widened_.data();
+				if (downmix_)
+				{
+					SimdKernels::DownmixToStereo(samples, count, channels_, coefficients_, mixed_.data());
+					samples = mixed_.data();
+				}
+				const size_t outputCount = count * outputChannels_;
+				SimdKernels::FloatToInt16Dithered(
+					samples,
+					target + done * outputChannels_ * 2,
+					outputCount,
+					ditherPosition_
+				);
+				ditherPosition_ += static_cast<uint32_t>(outputCount);
+				done += count;
+			}
+		}
+
+	private:
+		SampleFormat format_ = SampleFormat::Int16;
+		uint32_t channels_ = 0;
+		uint32_t outputChannels_ = 0;
+		bool downmix_ = false;
+		float coefficients_[2 * SimdKernels::maxDownmixChannels]{};
+		uint32_t ditherPosition_ = 0;
+		std::vector<float> widened_{};
+		std::vector<float> mixed_{};
+	};
+
+	// Decoders that can only produce the source's own layout leave a multichannel song to be folded here, inside
+	// its own buffer, which is then trimmed to the stereo size.
+	void DownmixPcmWemInPlace(std::vector<uint8_t>& wemBytes, uint32_t& channels, uint32_t& channelMask)
+	{
+		PcmConverter converter(SampleFormat::Int16, channels, channelMask);
+		if (!converter.NeedsConversion() || !converter.IsSupported())
+		{
+			return;
+		}
+
+		uint8_t* samples = wemBytes.data() + pcmWemHeaderSize;
+		const size_t frames = (wemBytes.size() - pcmWemHeaderSize) / converter.SourceFrameSize();
+		converter.Convert(samples, frames, samples);
+		wemBytes.resize(pcmWemHeaderSize + frames * converter.OutputChannels() * 2);
+		wemBytes.shrink_to_fit();
+		channels = converter.OutputChannels();
+		channelMask = 0;
+	}
+
+	// Decoders append samples straight after the header space, so the finished media is built in one buffer
+	// without copying the PCM again.
+	void BeginPcmWem(std::vector<uint8_t>& wemBytes, size_t expectedPcmBytes)
+	{
+		wemBytes.clear();
+		wemBytes.reserve(pcmWemHeaderSize + (std::min)(expectedPcmBytes, maxPcmByteCount));
+		wemBytes.resize(pcmWemHeaderSize);
 	}
 
 	bool FinishPcmDecode(
 		const std::string& path,
-		const std::vector<uint8_t>& pcmBytes,
+		std::vector<uint8_t>& wemBytes,
 		uint32_t channels,
 		uint32_t sampleRate,
 		uint32_t bitsPerSample,
-		AudioDecoder::WwiseMediaBuffer& output
+		AudioDecoder::WwiseMediaBuffer& output,
+		uint32_t channelMask = 0
 	)
 	{
-		if (!BuildPcmWemBytes(pcmBytes, channels, sampleRate, bitsPerSample, output.bytes))
+		if (bitsPerSample == 16 && wemBytes.size() > pcmWemHeaderSize)
+		{
+			DownmixPcmWemInPlace(wemBytes, channels, channelMask);
+		}
+
+		const size_t pcmByteCount = wemBytes.size() > pcmWemHeaderSize ? wemBytes.size() - pcmWemHeaderSize : 0;
+		if (
+			pcmByteCount == 0
+			|| pcmByteCount > maxPcmByteCount
+			|| !IsValidPcmFormat(channels, sampleRate, bitsPerSample)
+		)
 		{
 			return false;
 		}
 
+		WritePcmWemHeader(
+			wemBytes.data(),
+			channels,
+			sampleRate,
+			bitsPerSample,
+			static_cast<uint32_t>(pcmByteCount),
+			channelMask
+		);
 		output.path = path;
+		output.bytes = std::move(wemBytes);
 		output.sourcePluginId = wwisePcmSourcePluginId;
-		output.durationMs = CalculatePcmDurationMs(pcmBytes.size(), channels, sampleRate, bitsPerSample);
+		output.durationMs = CalculatePcmDurationMs(pcmByteCount, channels, sampleRate, bitsPerSample);
 		output.channels = channels;
 		output.sampleRate = sampleRate;
 		output.bitsPerSample = bitsPerSample;
@@ -477,7 +769,114 @@ namespace
 		return true;
 	}
 
-	bool DecodeAudioFileWithMediaFoundation(const std::string& path, AudioDecoder::WwiseMediaBuffer& output)
+	// MF_PD_DURATION is in 100 ns units. Half a second of slack absorbs rounding and encoder padding, so the
+	// reservation is normally never outgrown.
+	size_t EstimatePcmByteCount(IMFSourceReader* reader, uint32_t channels, uint32_t sampleRate, uint32_t bitsPerSample)
+	{
+		PROPVARIANT duration{};
+		PropVariantInit(&duration);
+		const HRESULT result = reader->GetPresentationAttribute(
+			static_cast<DWORD>(MF_SOURCE_READER_MEDIASOURCE),
+			MF_PD_DURATION,
+			&duration
+		);
+		const bool hasDuration = SUCCEEDED(result) && duration.vt == VT_UI8;
+		const unsigned long long duration100ns = hasDuration ? duration.uhVal.QuadPart : 0;
+		PropVariantClear(&duration);
+		if (!hasDuration)
+		{
+			return 0;
+		}
+
+		const unsigned long long byteRate =
+			static_cast<unsigned long long>(channels) * (bitsPerSample / 8) * sampleRate;
+		const unsigned long long seconds = duration100ns / 10000000ULL;
+		const unsigned long long remainder = duration100ns % 10000000ULL;
+		const unsigned long long estimate = seconds * byteRate + remainder * byteRate / 10000000ULL + byteRate / 2;
+		return static_cast<size_t>((std::min)(estimate, static_cast<unsigned long long>(maxPcmByteCount)));
+	}
+
+	// Asking Media Foundation for 16-bit output truncates anything finer, so sources that carry more are requested
+	// in their own precision and dithered down by PcmConverter instead. 16-bit PCM sources and layouts too wide to
+	// downmix keep the plain 16-bit request.
+	void ChooseMediaFoundationOutput(IMFSourceReader* reader, GUID& subtype, UINT32& bitsPerSample)
+	{
+		subtype = MFAudioFormat_PCM;
+		bitsPerSample = 16;
+
+		IMFMediaType* rawNativeType = nullptr;
+		const HRESULT result = reader->GetNativeMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, 0, &rawNativeType);
+		UniqueComPtr<IMFMediaType> nativeType(rawNativeType);
+		GUID nativeSubtype{};
+		UINT32 nativeChannels = 0;
+		UINT32 nativeBits = 0;
+		if (
+			FAILED(result)
+			|| !nativeType
+			|| FAILED(nativeType->GetGUID(MF_MT_SUBTYPE, &nativeSubtype))
+			|| FAILED(nativeType->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &nativeChannels))
+			|| nativeChannels > SimdKernels::maxDownmixChannels
+		)
+		{
+			return;
+		}
+
+		if (nativeSubtype == MFAudioFormat_PCM)
+		{
+			if (
+				SUCCEEDED(nativeType->GetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, &nativeBits))
+				&& (nativeBits == 24 || nativeBits == 32)
+			)
+			{
+				bitsPerSample = nativeBits;
+			}
+			return;
+		}
+
+		// Lossy decoders produce float internally; anything else is asked for float too rather than guessing.
+		subtype = MFAudioFormat_Float;
+		bitsPerSample = 32;
+	}
+
+	bool SetMediaFoundationOutput(IMFSourceReader* reader, IMFMediaType* targetType, const GUID& subtype, UINT32 bits)
+	{
+		targetType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
+		targetType->SetGUID(MF_MT_SUBTYPE, subtype);
+		targetType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, bits);
+		return SUCCEEDED(reader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, nullptr, targetType));
+	}
+
+	bool GetSampleFormat(const GUID& subtype, UINT32 bitsPerSample, SampleFormat& format)
+	{
+		if (subtype == MFAudioFormat_Float && bitsPerSample == 32)
+		{
+			format = SampleFormat::Float32;
+			return true;
+		}
+		if (subtype != MFAudioFormat_PCM)
+		{
+			return false;
+		}
+
+		switch (bitsPerSample)
+		{
+			case 16: format = SampleFormat::Int16; return true;
+			case 24: format = SampleFormat::Int24; return true;
+			case 32: format = SampleFormat::Int32; return true;
+			default: return false;
+		}
+	}
+
+	bool IsCanceled(const std::atomic<bool>* canceled)
+	{
+		return canceled && canceled->load();
+	}
+
+	bool DecodeAudioFileWithMediaFoundation(
+		const std::string& path,
+		AudioDecoder::WwiseMediaBuffer& output,
+		const std::atomic<bool>* canceled
+	)
 	{
 		MediaFoundationScope mediaFoundation;
 		if (!mediaFoundation.Initialize())
@@ -522,18 +921,18 @@ namespace
 			return false;
 		}
 
-		targetType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
-		targetType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM);
-		targetType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, 16);
-
-		result = reader->SetCurrentMediaType(
-			MF_SOURCE_READER_FIRST_AUDIO_STREAM,
-			nullptr,
-			targetType.get()
-		);
-		if (FAILED(result))
+		GUID requestedSubtype{};
+		UINT32 requestedBits = 0;
+		ChooseMediaFoundationOutput(reader.get(), requestedSubtype, requestedBits);
+		if (
+			!SetMediaFoundationOutput(reader.get(), targetType.get(), requestedSubtype, requestedBits)
+			&& (
+				(requestedSubtype == MFAudioFormat_PCM && requestedBits == 16)
+				|| !SetMediaFoundationOutput(reader.get(), targetType.get(), MFAudioFormat_PCM, 16)
+			)
+		)
 		{
-			Logging::Write(logPrefix, "Failed to request PCM decode for %s (0x%08x)", path.c_str(), result);
+			Logging::Write(logPrefix, "Failed to request PCM decode for %s", path.c_str());
 			return false;
 		}
 
@@ -550,14 +949,9 @@ namespace
 		UINT32 channels = 0;
 		UINT32 sampleRate = 0;
 		UINT32 bitsPerSample = 0;
-		result = currentType->GetGUID(MF_MT_SUBTYPE, &subtype);
-		if (FAILED(result) || subtype != MFAudioFormat_PCM)
-		{
-			Logging::Write(logPrefix, "Media Foundation did not provide PCM output for %s", path.c_str());
-			return false;
-		}
 		if (
-			FAILED(currentType->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &channels))
+			FAILED(currentType->GetGUID(MF_MT_SUBTYPE, &subtype))
+			|| FAILED(currentType->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &channels))
 			|| FAILED(currentType->GetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, &sampleRate))
 			|| FAILED(currentType->GetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, &bitsPerSample))
 		)
@@ -566,9 +960,33 @@ namespace
 			return false;
 		}
 
-		std::vector<uint8_t> pcmBytes;
+		SampleFormat sampleFormat = SampleFormat::Int16;
+		if (!GetSampleFormat(subtype, bitsPerSample, sampleFormat))
+		{
+			Logging::Write(logPrefix, "Media Foundation did not provide PCM output for %s", path.c_str());
+			return false;
+		}
+
+		// A mask the decoder does not report falls back to the default layout for the channel count.
+		const UINT32 channelMask = MFGetAttributeUINT32(currentType.get(), MF_MT_AUDIO_CHANNEL_MASK, 0);
+		PcmConverter converter(sampleFormat, channels, channelMask);
+		if (channels == 0 || (converter.NeedsConversion() && !converter.IsSupported()))
+		{
+			Logging::Write(logPrefix, "Decoded layout of %s cannot be converted to PCM WEM", path.c_str());
+			return false;
+		}
+		const uint32_t outputChannels = converter.OutputChannels();
+		const size_t sourceFrameSize = converter.SourceFrameSize();
+
+		std::vector<uint8_t> wemBytes;
+		BeginPcmWem(wemBytes, EstimatePcmByteCount(reader.get(), outputChannels, sampleRate, 16));
 		for (;;)
 		{
+			if (IsCanceled(canceled))
+			{
+				return false;
+			}
+
 			DWORD streamIndex = 0;
 			DWORD flags = 0;
 			LONGLONG timestamp = 0;
@@ -617,34 +1035,168 @@ namespace
 
 			if (sampleData.bytes && sampleData.size > 0)
 			{
-				if (sampleData.size > maxPcmByteCount || pcmBytes.size() > maxPcmByteCount - sampleData.size)
+				const size_t frames = sampleData.size / sourceFrameSize;
+				const size_t convertedSize = frames * outputChannels * sizeof(int16_t);
+				const size_t pcmByteCount = wemBytes.size() - pcmWemHeaderSize;
+				if (convertedSize > maxPcmByteCount || pcmByteCount > maxPcmByteCount - convertedSize)
 				{
 					Logging::Write(logPrefix, "Decoded audio is too large for Wwise media memory: %s", path.c_str());
 					return false;
 				}
-				pcmBytes.insert(pcmBytes.end(), sampleData.bytes, sampleData.bytes + sampleData.size);
+				wemBytes.resize(wemBytes.size() + convertedSize);
+				converter.Convert(sampleData.bytes, frames, wemBytes.data() + pcmWemHeaderSize + pcmByteCount);
 			}
 		}
 
-		if (!FinishPcmDecode(path, pcmBytes, channels, sampleRate, bitsPerSample, output))
+		// A layout the converter folded to stereo no longer matches the decoder's mask.
+		const uint32_t outputMask = outputChannels == channels ? channelMask : 0;
+		if (!FinishPcmDecode(path, wemBytes, outputChannels, sampleRate, 16, output, outputMask))
 		{
 			Logging::Write(logPrefix, "Failed to build PCM WEM media bytes for %s", path.c_str());
 			return false;
 		}
 
 		Logging::Write(logPrefix,
-			"Decoded %s to PCM WEM with Media Foundation (%u Hz, %u channel(s), %u-bit, %lld ms, %zu bytes)",
+			"Decoded %s to PCM WEM with Media Foundation "
+			"(%u Hz, %u to %u channel(s), %u-bit %s source, %lld ms, %zu bytes)",
 			path.c_str(),
 			sampleRate,
 			channels,
+			outputChannels,
 			bitsPerSample,
+			sampleFormat == SampleFormat::Float32 ? "float" : "integer",
+			output.durationMs,
+			output.bytes.size()
+		);
+		return true;
+	}
+
+	bool IsPcmFileExtension(const std::string& path)
+	{
+		const std::string extension = Utils::GetLowerExtension(path);
+		for (std::string_view pcmExtension : pcmFileExtensions)
+		{
+			if (extension == pcmExtension)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// 16-bit WAV and AIFF files already hold samples Wwise can play, so they only need a PCM WEM header. The file
+	// is mapped and its samples are copied once, straight behind the header.
+	bool LoadPcmFileDirectly(const std::string& path, AudioDecoder::WwiseMediaBuffer& output)
+	{
+		MappedFile file{};
+		PcmFileParser::PcmLayout layout{};
+		if (
+			!file.Open(Utils::ToWidePath(path))
+			|| !PcmFileParser::Parse(file.Data(), static_cast<size_t>(file.Size()), layout)
+			|| layout.dataSize > maxPcmByteCount
+		)
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> wemBytes;
+		BeginPcmWem(wemBytes, layout.dataSize);
+		wemBytes.resize(pcmWemHeaderSize + layout.dataSize);
+		uint8_t* samples = wemBytes.data() + pcmWemHeaderSize;
+		if (!file.Read(layout.dataOffset, samples, layout.dataSize))
+		{
+			Logging::Write(logPrefix, "Failed to read PCM samples from %s", path.c_str());
+			return false;
+		}
+		if (layout.bigEndian)
+		{
+			SimdKernels::ByteSwap16(samples, samples, layout.dataSize / 2);
+		}
+
+		if (!FinishPcmDecode(
+			path,
+			wemBytes,
+			layout.channels,
+			layout.sampleRate,
+			layout.bitsPerSample,
+			output,
+			layout.channelMask
+		))
+		{
+			return false;
+		}
+		// Rebuilding this is as cheap as reading a cached copy would be, so it stays out of the transcode cache.
+		output.decodedToPcm = false;
+
+		Logging::Write(logPrefix,
+			"Loaded %s as PCM WEM without decoding (%u Hz, %u channel(s), %u-bit, %lld ms, %zu bytes)",
+			path.c_str(),
+			output.sampleRate,
+			output.channels,
+			output.bitsPerSample,
+			output.durationMs,
+			output.bytes.size()
+		);
+		return true;
+	}
+
+	// FLAC is decoded here rather than through Media Foundation, whose FLAC support depends on the Windows build
+	// and which would otherwise leave lossless songs to ffmpeg. The decoder writes straight in behind the header.
+	bool DecodeFlacInProcess(
+		const std::string& path,
+		AudioDecoder::WwiseMediaBuffer& output,
+		const std::atomic<bool>* canceled
+	)
+	{
+		MappedFile file{};
+		if (!file.Open(Utils::ToWidePath(path)))
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> wemBytes(pcmWemHeaderSize);
+		FlacDecoder::StreamInfo info{};
+		if (!FlacDecoder::Decode(
+			file.Data(),
+			static_cast<size_t>(file.Size()),
+			wemBytes,
+			info,
+			maxPcmByteCount,
+			canceled
+		))
+		{
+			if (!IsCanceled(canceled))
+			{
+				Logging::Write(logPrefix, "In-process FLAC decode failed for %s", path.c_str());
+			}
+			return false;
+		}
+
+		constexpr uint32_t bitsPerSample = 16;
+		if (!FinishPcmDecode(path, wemBytes, info.channels, info.sampleRate, bitsPerSample, output, info.channelMask))
+		{
+			Logging::Write(logPrefix, "Failed to build FLAC PCM WEM media bytes for %s", path.c_str());
+			return false;
+		}
+
+		Logging::Write(logPrefix,
+			"Decoded %s to PCM WEM in process (%u Hz, %u channel(s), %u-bit source, %lld ms, %zu bytes)",
+			path.c_str(),
+			info.sampleRate,
+			info.channels,
+			info.bitsPerSample,
 			output.durationMs,
 			output.bytes.size()
 		);
 		return true;
 	}
 
-	bool DecodeAudioFileWithFfmpeg(const std::string& path, AudioDecoder::WwiseMediaBuffer& output)
+	bool DecodeAudioFileWithFfmpeg(
+		const std::string& path,
+		AudioDecoder::WwiseMediaBuffer& output,
+		const std::atomic<bool>* canceled
+	)
 	{
 		const std::string filename = Utils::FilenameFromPath(path);
 		const std::wstring widePath = Utils::ToWidePath(path);
@@ -668,41 +1220,40 @@ namespace
 			return false;
 		}
 
-		std::wstring rawPcmPath;
-		if (!Utils::CreateTempFilePath(rawPcmPath))
-		{
-			Logging::Write(logPrefix, "Failed to create temporary PCM output path for %s", filename.c_str());
-			return false;
-		}
-
-		std::wstring commandLine =
+		const std::wstring commandLine =
 			Utils::QuoteCommandLineArgument(ffmpegPath)
-			+ L" -hide_banner -loglevel error -i "
+			+ L" -hide_banner -nostdin -loglevel error -i "
 			+ Utils::QuoteCommandLineArgument(widePath)
-			+ L" -vn -f s16le -acodec pcm_s16le -ac 2 -ar 48000 -y "
-			+ Utils::QuoteCommandLineArgument(rawPcmPath);
+			+ L" -vn -f s16le -acodec pcm_s16le -ac 2 -ar 48000 pipe:1";
 
+		constexpr uint32_t channels = 2;
+		constexpr uint32_t sampleRate = 48000;
+		constexpr uint32_t bitsPerSample = 16;
+
+		// ffmpeg streams raw samples over its stdout straight in behind room for the header, which FinishPcmDecode
+		// fills in place. The probed duration sizes the buffer up front, with half a second of slack like the
+		// Media Foundation estimate, so the pipe reads never regrow it.
+		AudioProbe::AudioInfo probe{};
+		constexpr unsigned long long byteRate = channels * (bitsPerSample / 8) * sampleRate;
+		const size_t expectedPcmBytes = AudioDecoder::Probe(path, probe) && probe.durationMs > 0
+			? static_cast<size_t>((std::min)(
+				static_cast<unsigned long long>(probe.durationMs) * byteRate / 1000 + byteRate / 2,
+				static_cast<unsigned long long>(maxPcmByteCount)
+			))
+			: 0;
+		std::vector<uint8_t> wemBytes;
+		BeginPcmWem(wemBytes, expectedPcmBytes);
 		DWORD exitCode = 1;
-		if (!Utils::RunProcessAndWait(commandLine, 300000, exitCode) || exitCode != 0)
+		if (
+			!Utils::RunProcessCapturingOutput(commandLine, 300000, exitCode, wemBytes, maxPcmByteCount, canceled)
+			|| exitCode != 0
+		)
 		{
-			DeleteFileW(rawPcmPath.c_str());
 			Logging::Write(logPrefix, "ffmpeg failed while decoding %s (exit=%lu)", filename.c_str(), exitCode);
 			return false;
 		}
 
-		std::vector<uint8_t> pcmBytes;
-		if (!Utils::ReadFileBytesWide(rawPcmPath, pcmBytes, maxPcmByteCount))
-		{
-			DeleteFileW(rawPcmPath.c_str());
-			Logging::Write(logPrefix, "Failed to read ffmpeg PCM output for %s", filename.c_str());
-			return false;
-		}
-		DeleteFileW(rawPcmPath.c_str());
-
-		constexpr uint32_t channels = 2;
-		constexpr uint32_t sampleRate = 48000;
-		constexpr uint32_t bitsPerSample = 16;
-		if (!FinishPcmDecode(path, pcmBytes, channels, sampleRate, bitsPerSample, output))
+		if (!FinishPcmDecode(path, wemBytes, channels, sampleRate, bitsPerSample, output))
 		{
 			Logging::Write(logPrefix, "Failed to build ffmpeg PCM WEM media bytes for %s", filename.c_str());
 			return false;
@@ -719,6 +1270,90 @@ namespace
 		);
 		return true;
 	}
+
+	bool DecodeCustomAudioFile(
+		const std::string& path,
+		AudioDecoder::WwiseMediaBuffer& output,
+		const std::atomic<bool>* canceled
+	)
+	{
+		if (IsPcmFileExtension(path) && LoadPcmFileDirectly(path, output))
+		{
+			return true;
+		}
+
+		if (Utils::EndsWithExtension(path, ".flac") && DecodeFlacInProcess(path, output, canceled))
+		{
+			return true;
+		}
+		if (IsCanceled(canceled))
+		{
+			return false;
+		}
+
+		if (DecodeAudioFileWithMediaFoundation(path, output, canceled))
+		{
+			return true;
+		}
+
+		return !IsCanceled(canceled) && DecodeAudioFileWithFfmpeg(path, output, canceled);
+	}
+
+	// Re-encodes a freshly decoded 16-bit PCM WEM as Wwise ADPCM inside the same buffer, then trims the buffer so
+	// only the smaller media stays resident.
+	bool EncodeImaAdpcmWem(AudioDecoder::WwiseMediaBuffer& media)
+	{
+		std::vector<uint8_t>& bytes = media.bytes;
+		if (
+			media.sourcePluginId != wwisePcmSourcePluginId
+			|| media.bitsPerSample != 16
+			|| media.channels == 0
+			|| media.channels > ImaAdpcmEncoder::maxChannels
+			|| bytes.size() <= pcmWemHeaderSize
+		)
+		{
+			return false;
+		}
+
+		const uint32_t channelMask = Utils::ReadLe32FromBytes(bytes, 40);
+		const size_t frameCount = (bytes.size() - pcmWemHeaderSize) / (static_cast<size_t>(media.channels) * 2);
+		const size_t encodedSize = ImaAdpcmEncoder::GetEncodedSize(frameCount, media.channels);
+		if (frameCount == 0 || encodedSize > maxPcmByteCount)
+		{
+			return false;
+		}
+
+		// Only the last block's padding can make a very short song grow.
+		if (bytes.size() < adpcmWemHeaderSize + encodedSize)
+		{
+			bytes.resize(adpcmWemHeaderSize + encodedSize);
+		}
+		if (!ImaAdpcmEncoder::Encode(
+			bytes.data() + pcmWemHeaderSize,
+			frameCount,
+			media.channels,
+			bytes.data() + adpcmWemHeaderSize
+		))
+		{
+			return false;
+		}
+		WriteAdpcmWemHeader(
+			bytes.data(),
+			media.channels,
+			media.sampleRate,
+			static_cast<uint32_t>(encodedSize),
+			channelMask
+		);
+		bytes.resize(adpcmWemHeaderSize + encodedSize);
+		bytes.shrink_to_fit();
+
+		const uint64_t sampleCount = static_cast<uint64_t>(ImaAdpcmEncoder::GetBlockCount(frameCount))
+			* ImaAdpcmEncoder::samplesPerBlock;
+		media.sourcePluginId = wwiseAdpcmSourcePluginId;
+		media.bitsPerSample = 4;
+		media.durationMs = static_cast<long long>((sampleCount * 1000ULL) / media.sampleRate);
+		return true;
+	}
 }
 
 namespace AudioDecoder
@@ -741,7 +1376,26 @@ namespace AudioDecoder
 		return IsSupportedExtension(formattedExt);
 	}
 
-	bool LoadWwiseMedia(const std::string& path, WwiseMediaBuffer& output)
+	uint32_t GetSourcePluginId(OutputEncoding encoding)
+	{
+		return encoding == OutputEncoding::ImaAdpcm ? wwiseAdpcmSourcePluginId : wwisePcmSourcePluginId;
+	}
+
+	bool Probe(const std::string& path, AudioProbe::AudioInfo& info)
+	{
+		info = {};
+		MappedFile file{};
+		return !path.empty()
+			&& file.Open(Utils::ToWidePath(path))
+			&& AudioProbe::Probe(file.Data(), static_cast<size_t>(file.Size()), info);
+	}
+
+	bool LoadWwiseMedia(
+		const std::string& path,
+		WwiseMediaBuffer& output,
+		const std::atomic<bool>* canceled,
+		OutputEncoding encoding
+	)
 	{
 		output = {};
 		if (path.empty())
@@ -757,12 +1411,30 @@ namespace AudioDecoder
 				return false;
 			}
 
-			if (DecodeAudioFileWithMediaFoundation(path, output))
+			if (!DecodeCustomAudioFile(path, output, canceled))
+			{
+				return false;
+			}
+			if (encoding != OutputEncoding::ImaAdpcm || IsCanceled(canceled))
 			{
 				return true;
 			}
 
-			return DecodeAudioFileWithFfmpeg(path, output);
+			const size_t pcmSize = output.bytes.size();
+			if (!EncodeImaAdpcmWem(output))
+			{
+				Logging::Write(logPrefix, "Keeping %s as PCM; it could not be encoded as ADPCM", path.c_str());
+				return true;
+			}
+			// Even a WAV file that needed no decode is worth caching once it has been encoded.
+			output.decodedToPcm = true;
+			Logging::Write(logPrefix,
+				"Encoded %s as ADPCM WEM (%zu bytes, was %zu bytes as PCM)",
+				path.c_str(),
+				output.bytes.size(),
+				pcmSize
+			);
+			return true;
 		}
 
 		std::vector<uint8_t> bytes;
@@ -777,7 +1449,7 @@ namespace AudioDecoder
 		const uint16_t formatTag = DetectRiffFormatTag(output.bytes);
 		output.sourcePluginId = (formatTag == 1 || formatTag == 0xfffe)
 			? wwisePcmSourcePluginId
-			: wwiseVorbisSourcePluginId;
+			: formatTag == waveFormatImaAdpcm ? wwiseAdpcmSourcePluginId : wwiseVorbisSourcePluginId;
 
 		TryReadPcmWaveDuration(
 			output.bytes,
@@ -786,6 +1458,10 @@ namespace AudioDecoder
 			output.sampleRate,
 			output.bitsPerSample
 		);
+		if (output.durationMs == 0 && output.sourcePluginId == wwiseAdpcmSourcePluginId)
+		{
+			TryReadImaAdpcmWaveDuration(output.bytes, output.durationMs, output.channels, output.sampleRate);
+		}
 		if (output.durationMs == 0 && output.sourcePluginId == wwiseVorbisSourcePluginId)
 		{
 			uint32_t channels = 0;
@@ -0,0 +1,686 @@
+#include "AudioProbe.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr uint16_t waveFormatPcm = 1;
+	constexpr uint16_t waveFormatImaAdpcm = 2;
+	constexpr uint16_t waveFormatFloat = 3;
+	constexpr uint16_t waveFormatDviAdpcm = 0x11;
+	constexpr uint16_t waveFormatWwiseVorbis = 0xffff;
+	constexpr uint16_t waveFormatExtensible = 0xfffe;
+
+	constexpr size_t flacStreamInfoSize = 34;
+	constexpr size_t oggPageHeaderSize = 27;
+	// A page holds at most 255 segments of 255 bytes, so the last one always starts within this much of the end.
+	constexpr size_t maxOggPageSize = oggPageHeaderSize + 255 + 255 * 255;
+	constexpr uint64_t unknownGranulePosition = ~0ull;
+	constexpr uint32_t opusSampleRate = 48000;
+	// How far past an ID3v2 tag a first MPEG audio frame is looked for.
+	constexpr size_t maxMpegSyncSearch = 64 * 1024;
+	constexpr size_t id3v1TagSize = 128;
+
+	uint16_t ReadLe16(const uint8_t* bytes)
+	{
+		return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+	}
+
+	uint32_t ReadLe32(const uint8_t* bytes)
+	{
+		return static_cast<uint32_t>(bytes[0])
+			| (static_cast<uint32_t>(bytes[1]) << 8)
+			| (static_cast<uint32_t>(bytes[2]) << 16)
+			| (static_cast<uint32_t>(bytes[3]) << 24);
+	}
+
+	uint64_t ReadLe64(const uint8_t* bytes)
+	{
+		return static_cast<uint64_t>(ReadLe32(bytes)) | (static_cast<uint64_t>(ReadLe32(bytes + 4)) << 32);
+	}
+
+	uint16_t ReadBe16(const uint8_t* bytes)
+	{
+		return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+	}
+
+	uint32_t ReadBe32(const uint8_t* bytes)
+	{
+		return (static_cast<uint32_t>(bytes[0]) << 24)
+			| (static_cast<uint32_t>(bytes[1]) << 16)
+			| (static_cast<uint32_t>(bytes[2]) << 8)
+			| static_cast<uint32_t>(bytes[3]);
+	}
+
+	uint64_t ReadBe64(const uint8_t* bytes)
+	{
+		return (static_cast<uint64_t>(ReadBe32(bytes)) << 32) | ReadBe32(bytes + 4);
+	}
+
+	bool HasId(const uint8_t* bytes, const char* id)
+	{
+		return std::memcmp(bytes, id, 4) == 0;
+	}
+
+	long long FramesToMilliseconds(uint64_t frames, uint32_t sampleRate)
+	{
+		if (sampleRate == 0)
+		{
+			return 0;
+		}
+
+		// Split so a 64-bit sample count cannot overflow when scaled to milliseconds.
+		return static_cast<long long>((frames / sampleRate) * 1000 + (frames % sampleRate) * 1000 / sampleRate);
+	}
+
+	// AIFF stores the sample rate as an 80-bit IEEE extended float; fractional rates are rounded down.
+	uint32_t ReadExtendedSampleRate(const uint8_t* bytes)
+	{
+		const uint16_t signAndExponent = ReadBe16(bytes);
+		const uint64_t mantissa = ReadBe64(bytes + 2);
+		const int exponent = static_cast<int>(signAndExponent & 0x7fff) - 16383;
+		if ((signAndExponent & 0x8000) != 0 || exponent < 0 || exponent > 31)
+		{
+			return 0;
+		}
+		return static_cast<uint32_t>(mantissa >> (63 - exponent));
+	}
+
+	bool ProbeWave(const uint8_t* bytes, size_t size, AudioProbe::AudioInfo& info)
+	{
+		uint16_t formatTag = 0;
+		uint32_t blockAlign = 0;
+		uint32_t bitsPerSample = 0;
+		uint32_t samplesPerBlock = 0;
+		uint64_t wwiseSampleCount = 0;
+		uint64_t factSampleCount = 0;
+		uint64_t dataSize = 0;
+		bool hasFormat = false;
+		for (uint64_t position = 12; position + 8 <= size;)
+		{
+			const uint8_t* chunk = bytes + position;
+			const uint64_t chunkSize = ReadLe32(chunk + 4);
+			const uint64_t available = (std::min)(chunkSize, size - position - 8);
+			const uint8_t* data = chunk + 8;
+			if (HasId(chunk, "fmt ") && available >= 16)
+			{
+				hasFormat = true;
+				formatTag = ReadLe16(data);
+				info.channels = ReadLe16(data + 2);
+				info.sampleRate = ReadLe32(data + 4);
+				blockAlign = ReadLe16(data + 12);
+				bitsPerSample = ReadLe16(data + 14);
+				// The first two bytes of an extensible format's sub-format GUID are the plain format tag.
+				if (formatTag == waveFormatExtensible && available >= 26)
+				{
+					formatTag = ReadLe16(data + 24);
+				}
+				if ((formatTag == waveFormatImaAdpcm || formatTag == waveFormatDviAdpcm) && available >= 20)
+				{
+					samplesPerBlock = ReadLe16(data + 18);
+				}
+				if (formatTag == waveFormatWwiseVorbis && available >= 0x1c)
+				{
+					wwiseSampleCount = ReadLe32(data + 0x18);
+				}
+			}
+			else if (HasId(chunk, "fact") && available >= 4)
+			{
+				factSampleCount = ReadLe32(data);
+			}
+			else if (HasId(chunk, "data"))
+			{
+				dataSize = available;
+			}
+			position += 8 + chunkSize + (chunkSize & 1);
+		}
+
+		if (!hasFormat || info.channels == 0 || info.sampleRate == 0)
+		{
+			return false;
+		}
+
+		uint64_t frames = factSampleCount;
+		switch (formatTag)
+		{
+			case waveFormatPcm:
+			case waveFormatFloat:
+				info.codec = AudioProbe::Codec::Pcm;
+				if (blockAlign == 0)
+				{
+					blockAlign = info.channels * (bitsPerSample / 8);
+				}
+				frames = blockAlign != 0 ? dataSize / blockAlign : 0;
+				break;
+			case waveFormatImaAdpcm:
+			case waveFormatDviAdpcm:
+				info.codec = AudioProbe::Codec::ImaAdpcm;
+				if (frames == 0 && blockAlign != 0)
+				{
+					frames = dataSize / blockAlign * samplesPerBlock;
+				}
+				break;
+			case waveFormatWwiseVorbis:
+				info.codec = AudioProbe::Codec::WwiseVorbis;
+				frames = wwiseSampleCount;
+				break;
+			default:
+				info.codec = AudioProbe::Codec::Unknown;
+				break;
+		}
+		info.durationMs = FramesToMilliseconds(frames, info.sampleRate);
+		return true;
+	}
+
+	bool ProbeAiff(const uint8_t* bytes, size_t size, AudioProbe::AudioInfo& info)
+	{
+		const bool isAifc = HasId(bytes + 8, "AIFC");
+		for (uint64_t position = 12; position + 8 <= size;)
+		{
+			const uint8_t* chunk = bytes + position;
+			const uint64_t chunkSize = ReadBe32(chunk + 4);
+			const uint64_t available = (std::min)(chunkSize, size - position - 8);
+			const uint8_t* data = chunk + 8;
+			if (HasId(chunk, "COMM") && available >= 18)
+			{
+				info.channels = ReadBe16(data);
+				info.sampleRate = ReadExtendedSampleRate(data + 8);
+				if (info.channels == 0 || info.sampleRate == 0)
+				{
+					return false;
+				}
+
+				info.codec = AudioProbe::Codec::Pcm;
+				if (isAifc && available >= 22)
+				{
+					const uint8_t* compression = data + 18;
+					const bool uncompressed = HasId(compression, "NONE") || HasId(compression, "twos")
+						|| HasId(compression, "sowt") || HasId(compression, "fl32") || HasId(compression, "FL32")
+						|| HasId(compression, "fl64") || HasId(compression, "in24") || HasId(compression, "in32");
+					info.codec = uncompressed ? AudioProbe::Codec::Pcm : AudioProbe::Codec::Unknown;
+				}
+				info.durationMs = FramesToMilliseconds(ReadBe32(data + 2), info.sampleRate);
+				return true;
+			}
+			position += 8 + chunkSize + (chunkSize & 1);
+		}
+		return false;
+	}
+
+	// Fills in everything STREAMINFO holds; a total sample count of 0 means the encoder did not know it.
+	bool ReadFlacStreamInfo(const uint8_t* streamInfo, AudioProbe::AudioInfo& info)
+	{
+		info.codec = AudioProbe::Codec::Flac;
+		info.sampleRate = (static_cast<uint32_t>(streamInfo[10]) << 12)
+			| (static_cast<uint32_t>(streamInfo[11]) << 4)
+			| (streamInfo[12] >> 4);
+		info.channels = ((streamInfo[12] >> 1) & 0x7) + 1;
+		const uint64_t totalSamples = (static_cast<uint64_t>(streamInfo[13] & 0xf) << 32) | ReadBe32(streamInfo + 14);
+		info.durationMs = FramesToMilliseconds(totalSamples, info.sampleRate);
+		return info.sampleRate != 0;
+	}
+
+	// ID3v2 tags are written in front of MP3 files and, by some taggers, FLAC files; the size is sync-safe.
+	size_t SkipId3v2Tag(const uint8_t* bytes, size_t size)
+	{
+		if (size < 10 || std::memcmp(bytes, "ID3", 3) != 0)
+		{
+			return 0;
+		}
+
+		const size_t tagSize = (static_cast<size_t>(bytes[6] & 0x7f) << 21)
+			| (static_cast<size_t>(bytes[7] & 0x7f) << 14)
+			| (static_cast<size_t>(bytes[8] & 0x7f) << 7)
+			| (bytes[9] & 0x7f);
+		const size_t footerSize = (bytes[5] & 0x10) != 0 ? 10 : 0;
+		return (std::min)(size, 10 + tagSize + footerSize);
+	}
+
+	bool ProbeFlac(const uint8_t* bytes, size_t size, size_t offset, AudioProbe::AudioInfo& info)
+	{
+		// STREAMINFO is always the first metadata block.
+		if (
+			size - offset < 8 + flacStreamInfoSize
+			|| !HasId(bytes + offset, "fLaC")
+			|| (bytes[offset + 4] & 0x7f) != 0
+		)
+		{
+			return false;
+		}
+		return ReadFlacStreamInfo(bytes + offset + 8, info);
+	}
+
+	// Walks back from the end of the file to the last page of the stream that carries a granule position.
+	uint64_t FindLastOggGranulePosition(const uint8_t* bytes, size_t size, uint32_t serial)
+	{
+		const size_t searchStart = size > 4 * maxOggPageSize ? size - 4 * maxOggPageSize : 0;
+		for (size_t position = size - oggPageHeaderSize + 1; position-- > searchStart;)
+		{
+			const uint8_t* page = bytes + position;
+			if (!HasId(page, "OggS") || page[4] != 0 || ReadLe32(page + 14) != serial)
+			{
+				continue;
+			}
+
+			const uint64_t granulePosition = ReadLe64(page + 6);
+			if (granulePosition != unknownGranulePosition)
+			{
+				return granulePosition;
+			}
+		}
+		return unknownGranulePosition;
+	}
+
+	bool ProbeOgg(const uint8_t* bytes, size_t size, AudioProbe::AudioInfo& info)
+	{
+		const size_t segmentCount = bytes[26];
+		const size_t packetOffset = oggPageHeaderSize + segmentCount;
+		if (size < packetOffset)
+		{
+			return false;
+		}
+
+		// Every Ogg mapping puts its identification header alone on the first page.
+		size_t packetSize = 0;
+		for (size_t segment = 0; segment < segmentCount; segment++)
+		{
+			packetSize += bytes[oggPageHeaderSize + segment];
+		}
+		packetSize = (std::min)(packetSize, size - packetOffset);
+		const uint8_t* packet = bytes + packetOffset;
+
+		uint64_t preSkip = 0;
+		uint32_t granuleRate = 0;
+		if (packetSize >= 30 && packet[0] == 1 && std::memcmp(packet + 1, "vorbis", 6) == 0)
+		{
+			info.codec = AudioProbe::Codec::Vorbis;
+			info.channels = packet[11];
+			info.sampleRate = ReadLe32(packet + 12);
+			granuleRate = info.sampleRate;
+		}
+		else if (packetSize >= 19 && std::memcmp(packet, "OpusHead", 8) == 0)
+		{
+			info.codec = AudioProbe::Codec::Opus;
+			info.channels = packet[9];
+			info.sampleRate = opusSampleRate;
+			preSkip = ReadLe16(packet + 10);
+			granuleRate = opusSampleRate;
+		}
+		else if (
+			packetSize >= 17 + flacStreamInfoSize
+			&& packet[0] == 0x7f
+			&& HasId(packet + 1, "FLAC")
+			&& HasId(packet + 9, "fLaC")
+		)
+		{
+			if (!ReadFlacStreamInfo(packet + 17, info))
+			{
+				return false;
+			}
+			granuleRate = info.sampleRate;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (info.channels == 0 || info.sampleRate == 0)
+		{
+			return false;
+		}
+		if (info.durationMs == 0)
+		{
+			const uint64_t granulePosition = FindLastOggGranulePosition(bytes, size, ReadLe32(bytes + 14));
+			if (granulePosition != unknownGranulePosition && granulePosition > preSkip)
+			{
+				info.durationMs = FramesToMilliseconds(granulePosition - preSkip, granuleRate);
+			}
+		}
+		return true;
+	}
+
+	struct MpegFrameHeader
+	{
+		uint32_t version = 0; // 1 for MPEG-1, 2 for MPEG-2 and MPEG-2.5
+		uint32_t layer = 0;
+		uint32_t bitrateKbps = 0;
+		uint32_t sampleRate = 0;
+		uint32_t channels = 0;
+		uint32_t samplesPerFrame = 0;
+		size_t frameSize = 0;
+	};
+
+	bool ParseMpegFrameHeader(const uint8_t* bytes, MpegFrameHeader& header)
+	{
+		static constexpr uint16_t bitratesKbps[5][15] = {
+			{ 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 }, // MPEG-1 layer I
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 }, // MPEG-1 layer II
+			{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }, // MPEG-1 layer III
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 }, // MPEG-2 layer I
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } // MPEG-2 layers II and III
+		};
+		static constexpr uint32_t mpeg1SampleRates[3] = { 44100, 48000, 32000 };
+
+		if (bytes[0] != 0xff || (bytes[1] & 0xe0) != 0xe0)
+		{
+			return false;
+		}
+
+		const uint32_t versionBits = (bytes[1] >> 3) & 0x3;
+		const uint32_t layerBits = (bytes[1] >> 1) & 0x3;
+		const uint32_t bitrateIndex = bytes[2] >> 4;
+		const uint32_t sampleRateIndex = (bytes[2] >> 2) & 0x3;
+		// Free format streams do not say how long their frames are; they are rare enough to leave to the decoder.
+		if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3)
+		{
+			return false;
+		}
+
+		header.version = versionBits == 3 ? 1 : 2;
+		header.layer = 4 - layerBits;
+		const size_t table = header.version == 1 ? header.layer - 1 : (header.layer == 1 ? 3 : 4);
+		header.bitrateKbps = bitratesKbps[table][bitrateIndex];
+		header.sampleRate = mpeg1SampleRates[sampleRateIndex] >> (versionBits == 3 ? 0 : (versionBits == 2 ? 1 : 2));
+		header.channels = (bytes[3] >> 6) == 3 ? 1 : 2;
+		header.samplesPerFrame = header.layer == 1 ? 384 : (header.layer == 3 && header.version == 2 ? 576 : 1152);
+
+		const size_t padding = (bytes[2] >> 1) & 0x1;
+		const size_t bitrate = static_cast<size_t>(header.bitrateKbps) * 1000;
+		header.frameSize = header.layer == 1
+			? (12 * bitrate / header.sampleRate + padding) * 4
+			: header.samplesPerFrame / 8 * bitrate / header.sampleRate + padding;
+		return true;
+	}
+
+	// A VBR file starts with a frame holding a Xing/Info or VBRI header that counts the frames after it.
+	uint64_t ReadMpegFrameCount(const uint8_t* frame, const MpegFrameHeader& header)
+	{
+		const size_t sideInfoSize = header.version == 1
+			? (header.channels == 1 ? 17 : 32)
+			: (header.channels == 1 ? 9 : 17);
+		const size_t xingOffset = 4 + sideInfoSize;
+		if (
+			header.frameSize >= xingOffset + 12
+			&& (HasId(frame + xingOffset, "Xing") || HasId(frame + xingOffset, "Info"))
+			&& (ReadBe32(frame + xingOffset + 4) & 0x1) != 0
+		)
+		{
+			return ReadBe32(frame + xingOffset + 8);
+		}
+
+		constexpr size_t vbriOffset = 4 + 32;
+		if (header.frameSize >= vbriOffset + 18 && HasId(frame + vbriOffset, "VBRI"))
+		{
+			return ReadBe32(frame + vbriOffset + 14);
+		}
+		return 0;
+	}
+
+	bool ProbeMpegAudio(const uint8_t* bytes, size_t size, size_t offset, AudioProbe::AudioInfo& info)
+	{
+		// A frame counts as found once the frame after it starts where its header says it ends, which keeps sync
+		// bytes inside tag data or album art from being taken for audio.
+		const size_t searchEnd = (std::min)(size, offset + maxMpegSyncSearch);
+		MpegFrameHeader header{};
+		size_t frameOffset = offset;
+		bool found = false;
+		for (; frameOffset + 4 <= searchEnd; frameOffset++)
+		{
+			MpegFrameHeader next{};
+			if (!ParseMpegFrameHeader(bytes + frameOffset, header) || header.frameSize > size - frameOffset)
+			{
+				continue;
+			}
+
+			const size_t nextOffset = frameOffset + header.frameSize;
+			found =
+				nextOffset == size
+				|| (
+					nextOffset + 4 <= size
+					&& ParseMpegFrameHeader(bytes + nextOffset, next)
+					&& next.version == header.version
+					&& next.layer == header.layer
+					&& next.sampleRate == header.sampleRate
+				);
+			if (found)
+			{
+				break;
+			}
+		}
+		if (!found)
+		{
+			return false;
+		}
+
+		info.codec = header.layer == 1
+			? AudioProbe::Codec::Mp1
+			: (header.layer == 2 ? AudioProbe::Codec::Mp2 : AudioProbe::Codec::Mp3);
+		info.sampleRate = header.sampleRate;
+		info.channels = header.channels;
+
+		const uint64_t frameCount = ReadMpegFrameCount(bytes + frameOffset, header);
+		if (frameCount != 0)
+		{
+			info.durationMs = FramesToMilliseconds(frameCount * header.samplesPerFrame, info.sampleRate);
+			return true;
+		}
+
+		size_t audioSize = size - frameOffset;
+		if (audioSize >= id3v1TagSize && std::memcmp(bytes + size - id3v1TagSize, "TAG", 3) == 0)
+		{
+			audioSize -= id3v1TagSize;
+		}
+		info.durationMs = static_cast<long long>(static_cast<uint64_t>(audioSize) * 8 / header.bitrateKbps);
+		info.durationEstimated = true;
+		return true;
+	}
+
+	struct Mp4Box
+	{
+		const uint8_t* payload = nullptr;
+		size_t payloadSize = 0;
+	};
+
+	// Finds the first child box of the given type, following 64-bit sizes and a size of 0 meaning "to the end".
+	bool FindMp4Box(const uint8_t* begin, size_t size, const char* type, Mp4Box& box)
+	{
+		for (size_t position = 0; position + 8 <= size;)
+		{
+			const uint8_t* header = begin + position;
+			uint64_t boxSize = ReadBe32(header);
+			size_t headerSize = 8;
+			if (boxSize == 1)
+			{
+				if (position + 16 > size)
+				{
+					return false;
+				}
+				boxSize = ReadBe64(header + 8);
+				headerSize = 16;
+			}
+			else if (boxSize == 0)
+			{
+				boxSize = size - position;
+			}
+			if (boxSize < headerSize || boxSize > size - position)
+			{
+				return false;
+			}
+
+			if (HasId(header + 4, type))
+			{
+				box.payload = header + headerSize;
+				box.payloadSize = static_cast<size_t>(boxSize) - headerSize;
+				return true;
+			}
+			position += static_cast<size_t>(boxSize);
+		}
+		return false;
+	}
+
+	bool FindMp4Path(const Mp4Box& parent, const char* const* types, size_t typeCount, Mp4Box& box)
+	{
+		box = parent;
+		for (size_t index = 0; index < typeCount; index++)
+		{
+			if (!FindMp4Box(box.payload, box.payloadSize, types[index], box))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool ReadMp4SoundTrack(const Mp4Box& track, AudioProbe::AudioInfo& info)
+	{
+		static const char* const handlerPath[] = { "mdia", "hdlr" };
+		static const char* const headerPath[] = { "mdia", "mdhd" };
+		static const char* const descriptionPath[] = { "mdia", "minf", "stbl", "stsd" };
+
+		Mp4Box handler{};
+		if (
+			!FindMp4Path(track, handlerPath, 2, handler)
+			|| handler.payloadSize < 12
+			|| !HasId(handler.payload + 8, "soun")
+		)
+		{
+			return false;
+		}
+
+		Mp4Box mediaHeader{};
+		if (!FindMp4Path(track, headerPath, 2, mediaHeader) || mediaHeader.payloadSize < 24)
+		{
+			return false;
+		}
+		const bool longHeader = mediaHeader.payload[0] == 1;
+		if (longHeader && mediaHeader.payloadSize < 32)
+		{
+			return false;
+		}
+		const uint32_t timescale = ReadBe32(mediaHeader.payload + (longHeader ? 20 : 12));
+		const uint64_t duration = longHeader ? ReadBe64(mediaHeader.payload + 24) : ReadBe32(mediaHeader.payload + 16);
+		// All ones marks a duration the muxer never filled in.
+		const bool knownDuration = longHeader ? duration != ~0ull : duration != 0xffffffffull;
+
+		// The first sample entry is an AudioSampleEntry: its format, then the channel count and 16.16 sample rate
+		// after 16 reserved and versioning bytes.
+		Mp4Box description{};
+		if (!FindMp4Path(track, descriptionPath, 4, description) || description.payloadSize < 8 + 36)
+		{
+			return false;
+		}
+		const uint8_t* entry = description.payload + 8;
+		if (HasId(entry + 4, "mp4a"))
+		{
+			info.codec = AudioProbe::Codec::Aac;
+		}
+		else if (HasId(entry + 4, "alac"))
+		{
+			info.codec = AudioProbe::Codec::Alac;
+		}
+		else if (HasId(entry + 4, "Opus"))
+		{
+			info.codec = AudioProbe::Codec::Opus;
+		}
+		else if (HasId(entry + 4, "fLaC"))
+		{
+			info.codec = AudioProbe::Codec::Flac;
+		}
+		else
+		{
+			info.codec = AudioProbe::Codec::Unknown;
+		}
+		info.channels = ReadBe16(entry + 24);
+		info.sampleRate = ReadBe16(entry + 32);
+		// Rates above 65535 Hz do not fit the 16.16 field; the track timescale is the sample rate for audio.
+		if (info.sampleRate == 0)
+		{
+			info.sampleRate = timescale;
+		}
+		if (knownDuration && timescale != 0)
+		{
+			info.durationMs = FramesToMilliseconds(duration, timescale);
+		}
+		return info.channels != 0 && info.sampleRate != 0;
+	}
+
+	bool ProbeMp4(const uint8_t* bytes, size_t size, AudioProbe::AudioInfo& info)
+	{
+		Mp4Box movie{};
+		if (!FindMp4Box(bytes, size, "moov", movie))
+		{
+			return false;
+		}
+
+		// Tracks are walked in order so a video file's audio track is found after its video track.
+		for (size_t position = 0; position < movie.payloadSize;)
+		{
+			Mp4Box track{};
+			if (!FindMp4Box(movie.payload + position, movie.payloadSize - position, "trak", track))
+			{
+				return false;
+			}
+			if (ReadMp4SoundTrack(track, info))
+			{
+				return true;
+			}
+			info = {};
+			position = static_cast<size_t>(track.payload + track.payloadSize - movie.payload);
+		}
+		return false;
+	}
+}
+
+const char* AudioProbe::GetCodecName(Codec codec)
+{
+	switch (codec)
+	{
+		case Codec::Pcm: return "PCM";
+		case Codec::ImaAdpcm: return "IMA ADPCM";
+		case Codec::WwiseVorbis: return "Wwise Vorbis";
+		case Codec::Flac: return "FLAC";
+		case Codec::Vorbis: return "Vorbis";
+		case Codec::Opus: return "Opus";
+		case Codec::Mp1: return "MPEG Layer I";
+		case Codec::Mp2: return "MPEG Layer II";
+		case Codec::Mp3: return "MP3";
+		case Codec::Aac: return "AAC";
+		case Codec::Alac: return "ALAC";
+		default: return "unknown";
+	}
+}
+
+bool AudioProbe::Probe(const uint8_t* bytes, size_t size, AudioInfo& info)
+{
+	info = {};
+	if (!bytes || size < 12)
+	{
+		return false;
+	}
+
+	if (HasId(bytes, "RIFF") && HasId(bytes + 8, "WAVE"))
+	{
+		return ProbeWave(bytes, size, info);
+	}
+	if (HasId(bytes, "FORM") && (HasId(bytes + 8, "AIFF") || HasId(bytes + 8, "AIFC")))
+	{
+		return ProbeAiff(bytes, size, info);
+	}
+	if (HasId(bytes, "OggS"))
+	{
+		return size >= oggPageHeaderSize && ProbeOgg(bytes, size, info);
+	}
+	if (HasId(bytes + 4, "ftyp"))
+	{
+		return ProbeMp4(bytes, size, info);
+	}
+
+	const size_t audioOffset = SkipId3v2Tag(bytes, size);
+	if (ProbeFlac(bytes, size, audioOffset, info))
+	{
+		return true;
+	}
+	info = {};
+	return ProbeMpegAudio(bytes, size, audioOffset, info);
+}
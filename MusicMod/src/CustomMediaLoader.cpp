@@ -112,6 +112,7 @@ namespace CustomMediaLoader
 			}
 		);
 
+		size_t probedSongCount = 0;
 		for (const fs::directory_entry& audioFile : audioFiles)
 		{
 			try
@@ -170,6 +171,20 @@ namespace CustomMediaLoader
 				data.signature = "";
 				data.customAreaTrack = true;
 				data.customWemPath = StoreCustomSongString(absoluteAudioPathString);
+				data.compressCustomAudio = ModConfiguration::compressCustomSongs
+					|| ModConfiguration::compressedSongs.count(songInfo.filename) != 0;
+
+				// Only a duration read from a stored sample count is trusted as the song's length; a bitrate
+				// estimate could cut a VBR song short.
+				AudioProbe::AudioInfo audioInfo{};
+				if (AudioDecoder::Probe(absoluteAudioPathString, audioInfo) && !audioInfo.durationEstimated)
+				{
+					data.maxLength = audioInfo.durationMs;
+					if (data.maxLength > 0)
+					{
+						probedSongCount++;
+					}
+				}
 
 				ModConfiguration::Databases::customSongDatabase.emplace(songInfo.filename, data);
 				ModConfiguration::activePlaylist.insert(songInfo.filename);
@@ -193,7 +208,11 @@ namespace CustomMediaLoader
 			}
 		}
 
-		Logging::Write(logPrefix, "Loaded %zu custom tracks", ModConfiguration::Databases::customSongDatabase.size());
+		Logging::Write(logPrefix,
+			"Loaded %zu custom tracks (%zu with a known duration)",
+			ModConfiguration::Databases::customSongDatabase.size(),
+			probedSongCount
+		);
 		return true;
 	}
 
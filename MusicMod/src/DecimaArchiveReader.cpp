@@ -2,26 +2,43 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <Windows.h>
-#include <wincrypt.h>
 
+#include "DecimaHash.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "ModConfiguration.h"
+#include "SimdKernels.h"
 #include "Utils.h"
 
-#pragma comment(lib, "advapi32.lib")
-
 namespace
 {
+	constexpr const char* logPrefix = "Decima Archive Reader";
 	constexpr uint32_t decimaPackMagicPlain = 0x20304050;
 	constexpr uint32_t decimaPackMagicEncrypted = 0x21304050;
 	constexpr uint32_t decimaPackChunkSize = 0x40000;
+	constexpr size_t decimaPackHeaderSize = 40;
+	constexpr size_t maxChunkWorkers = 8;
+	constexpr size_t chunkPrefetchDepth = 16;
+	constexpr size_t tableDecodeBatchEntries = 64;
+	constexpr uint64_t fileTableSliceEntries = 32768;
 	constexpr const wchar_t* decimaInitialArchiveFilename =
 		L"7017f9bb9d52fc1c4433599203cc51b1.bin";
-	constexpr std::array<const wchar_t*, 2> decimaInitialArchiveDirectories{
+	constexpr std::array<const wchar_t*, 2> decimaArchiveDirectories{
 		L"data",
 		L"packed_GDK"
 	};
+	constexpr const wchar_t* archiveIndexFilename = L"walkingman_archives.idx";
 	constexpr uint64_t decimaHeaderKey0 = 0xf41cab62fa3a9443ull;
 	constexpr uint64_t decimaHeaderKey1 = 0xd2a89e3ef376811cull;
 	constexpr uint64_t decimaDataKey0 = 0x7e159d956c084a37ull;
@@ -46,31 +63,15 @@ namespace
 	{
 		DecimaPackSpan decompressed{};
 		DecimaPackSpan compressed{};
+		// XOR key for the compressed bytes; only derived for encrypted archives.
+		std::array<uint8_t, 16> dataKey{};
 	};
 
-	struct UniqueHandle
+	enum class PackChunkDecodeStatus
 	{
-		HANDLE handle = INVALID_HANDLE_VALUE;
-
-		explicit UniqueHandle(HANDLE value)
-			: handle(value)
-		{}
-
-		UniqueHandle(const UniqueHandle&) = delete;
-		UniqueHandle& operator=(const UniqueHandle&) = delete;
-
-		~UniqueHandle()
-		{
-			if (handle != INVALID_HANDLE_VALUE)
-			{
-				CloseHandle(handle);
-			}
-		}
-
-		bool IsValid() const
-		{
-			return handle != INVALID_HANDLE_VALUE;
-		}
+		Success,
+		ReadFailed,
+		DecompressFailed
 	};
 
 	using OodleLZDecompressFn = long long(__cdecl*)(
@@ -100,132 +101,110 @@ namespace
 		return { false, error, copiedBytes };
 	}
 
-	uint64_t Rotl64(uint64_t value, int bits)
-	{
-		return (value << bits) | (value >> (64 - bits));
-	}
-
-	uint64_t Fmix64(uint64_t value)
+	uint32_t Rotl32(uint32_t value, int shift)
 	{
-		value ^= value >> 33;
-		value *= 0xff51afd7ed558ccdull;
-		value ^= value >> 33;
-		value *= 0xc4ceb9fe1a85ec53ull;
-		value ^= value >> 33;
-		return value;
+		return (value << shift) | (value >> (32 - shift));
 	}
 
-	std::array<uint64_t, 2> MurmurHash3X64_128(const uint8_t* data, size_t length, uint32_t seed = 0x2a)
+	void Md5Transform(uint32_t state[4], const uint8_t block[64])
 	{
-		constexpr uint64_t c1 = 0x87c37b91114253d5ull;
-		constexpr uint64_t c2 = 0x4cf5ad432745937full;
-		uint64_t h1 = seed;
-		uint64_t h2 = seed;
+		static constexpr uint32_t sineTable[64] = {
+			0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+			0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+			0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+			0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+			0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+			0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+			0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+			0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+		};
+		static constexpr int shifts[64] = {
+			7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+			5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+			4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+			6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+		};
 
-		const size_t blockCount = length / 16;
-		for (size_t i = 0; i < blockCount; i++)
+		uint32_t words[16]{};
+		for (int i = 0; i < 16; i++)
 		{
-			uint64_t k1 = Utils::ReadLe64(data + i * 16);
-			uint64_t k2 = Utils::ReadLe64(data + i * 16 + 8);
-
-			k1 *= c1;
-			k1 = Rotl64(k1, 31);
-			k1 *= c2;
-			h1 ^= k1;
-
-			h1 = Rotl64(h1, 27);
-			h1 += h2;
-			h1 = h1 * 5 + 0x52dce729;
-
-			k2 *= c2;
-			k2 = Rotl64(k2, 33);
-			k2 *= c1;
-			h2 ^= k2;
-
-			h2 = Rotl64(h2, 31);
-			h2 += h1;
-			h2 = h2 * 5 + 0x38495ab5;
+			words[i] = Utils::ReadLe32(block + i * 4);
 		}
 
-		const uint8_t* tail = data + blockCount * 16;
-		uint64_t k1 = 0;
-		uint64_t k2 = 0;
-
-		switch (length & 15)
+		uint32_t a = state[0];
+		uint32_t b = state[1];
+		uint32_t c = state[2];
+		uint32_t d = state[3];
+		for (int i = 0; i < 64; i++)
 		{
-		case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
-		case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
-		case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
-		case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
-		case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
-		case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
-		case 9:
-			k2 ^= static_cast<uint64_t>(tail[8]);
-			k2 *= c2;
-			k2 = Rotl64(k2, 33);
-			k2 *= c1;
-			h2 ^= k2;
-			[[fallthrough]];
-		case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
-		case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
-		case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
-		case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
-		case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
-		case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
-		case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
-		case 1:
-			k1 ^= static_cast<uint64_t>(tail[0]);
-			k1 *= c1;
-			k1 = Rotl64(k1, 31);
-			k1 *= c2;
-			h1 ^= k1;
-			break;
-		default:
-			break;
-		}
-
-		h1 ^= length;
-		h2 ^= length;
-
-		h1 += h2;
-		h2 += h1;
-
-		h1 = Fmix64(h1);
-		h2 = Fmix64(h2);
+			uint32_t f = 0;
+			int g = 0;
+			if (i < 16)
+			{
+				f = (b & c) | (~b & d);
+				g = i;
+			}
+			else if (i < 32)
+			{
+				f = (d & b) | (~d & c);
+				g = (5 * i + 1) & 15;
+			}
+			else if (i < 48)
+			{
+				f = b ^ c ^ d;
+				g = (3 * i + 5) & 15;
+			}
+			else
+			{
+				f = c ^ (b | ~d);
+				g = (7 * i) & 15;
+			}
 
-		h1 += h2;
-		h2 += h1;
+			const uint32_t rotated = b + Rotl32(a + f + sineTable[i] + words[g], shifts[i]);
+			a = d;
+			d = c;
+			c = b;
+			b = rotated;
+		}
 
-		return { h1, h2 };
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
 	}
 
-	bool ComputeMd5(const uint8_t* bytes, size_t size, uint8_t digest[16])
+	// Plain RFC 1321 MD5. Keys are derived once per chunk at index time, so this never sits on the read path.
+	std::array<uint8_t, 16> ComputeMd5(const uint8_t* bytes, size_t size)
 	{
-		HCRYPTPROV provider = 0;
-		HCRYPTHASH hash = 0;
-		DWORD digestSize = 16;
-		bool success = false;
+		uint32_t state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
 
-		if (
-			CryptAcquireContextW(&provider, nullptr, nullptr, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT)
-			&& CryptCreateHash(provider, CALG_MD5, 0, 0, &hash)
-			&& CryptHashData(hash, bytes, static_cast<DWORD>(size), 0)
-			&& CryptGetHashParam(hash, HP_HASHVAL, digest, &digestSize, 0)
-			&& digestSize == 16
-		)
+		size_t offset = 0;
+		for (; offset + 64 <= size; offset += 64)
 		{
-			success = true;
+			Md5Transform(state, bytes + offset);
 		}
 
-		if (hash)
+		uint8_t tail[128]{};
+		const size_t remaining = size - offset;
+		if (remaining > 0)
 		{
-			CryptDestroyHash(hash);
+			std::memcpy(tail, bytes + offset, remaining);
 		}
-		if (provider)
+		tail[remaining] = 0x80;
+		const size_t tailSize = remaining < 56 ? 64 : 128;
+		Utils::WriteLe64(tail + tailSize - 8, static_cast<uint64_t>(size) * 8u);
+		Md5Transform(state, tail);
+		if (tailSize == 128)
 		{
-			CryptReleaseContext(provider, 0);
+			Md5Transform(state, tail + 64);
 		}
-		return success;
+
+		std::array<uint8_t, 16> digest{};
+		for (int i = 0; i < 4; i++)
+		{
+			Utils::WriteLe32(digest.data() + i * 4, state[i]);
+		}
+		return digest;
 	}
 
 	void XorLe64(uint8_t* bytes, uint64_t value)
@@ -239,47 +218,85 @@ namespace
 		Utils::WriteLe64(hashInput, decimaHeaderKey0);
 		Utils::WriteLe64(hashInput + 8, decimaHeaderKey1);
 		Utils::WriteLe32(hashInput, key1);
-		const auto hash1 = MurmurHash3X64_128(hashInput, sizeof(hashInput));
+		const auto hash1 = DecimaHash::MurmurHash3X64_128(hashInput, sizeof(hashInput));
 		XorLe64(bytes, hash1[0]);
 		XorLe64(bytes + 8, hash1[1]);
 
 		Utils::WriteLe64(hashInput, decimaHeaderKey0);
 		Utils::WriteLe64(hashInput + 8, decimaHeaderKey1);
 		Utils::WriteLe32(hashInput, key2);
-		const auto hash2 = MurmurHash3X64_128(hashInput, sizeof(hashInput));
+		const auto hash2 = DecimaHash::MurmurHash3X64_128(hashInput, sizeof(hashInput));
 		XorLe64(bytes + 16, hash2[0]);
 		XorLe64(bytes + 24, hash2[1]);
 	}
 
-	bool SwizzleDataBlock(uint8_t* bytes, size_t size, const DecimaPackSpan& decompressed)
+	// Decrypts count consecutive 32-byte table entries in place. Each entry needs two independent key hashes, so a
+	// run of entries is hashed as one batch and the vector kernel always has several keys in flight.
+	void SwizzleTableEntries(uint8_t* entries, size_t count, size_t key1Offset)
+	{
+		std::array<uint8_t, tableDecodeBatchEntries * 2 * 16> hashInputs{};
+		std::array<uint64_t, tableDecodeBatchEntries * 4> hashes{};
+		for (size_t base = 0; base < count; base += tableDecodeBatchEntries)
+		{
+			const size_t batchCount = (std::min)(count - base, tableDecodeBatchEntries);
+			for (size_t i = 0; i < batchCount; i++)
+			{
+				const uint8_t* entry = entries + (base + i) * 32;
+				uint8_t* input = hashInputs.data() + i * 32;
+				Utils::WriteLe64(input, decimaHeaderKey0);
+				Utils::WriteLe64(input + 8, decimaHeaderKey1);
+				Utils::WriteLe32(input, Utils::ReadLe32(entry + key1Offset));
+				Utils::WriteLe64(input + 16, decimaHeaderKey0);
+				Utils::WriteLe64(input + 24, decimaHeaderKey1);
+				Utils::WriteLe32(input + 16, Utils::ReadLe32(entry + 28));
+			}
+
+			SimdKernels::MurmurHash3X64_128Keys16(hashInputs.data(), batchCount * 2, 0x2a, hashes.data());
+
+			for (size_t i = 0; i < batchCount; i++)
+			{
+				uint8_t* entry = entries + (base + i) * 32;
+				const uint32_t key1 = Utils::ReadLe32(entry + key1Offset);
+				const uint32_t key2 = Utils::ReadLe32(entry + 28);
+				for (size_t word = 0; word < 4; word++)
+				{
+					XorLe64(entry + word * 8, hashes[i * 4 + word]);
+				}
+				Utils::WriteLe32(entry + key1Offset, key1);
+				Utils::WriteLe32(entry + 28, key2);
+			}
+		}
+	}
+
+	std::array<uint8_t, 16> DeriveDataBlockKey(const DecimaPackSpan& decompressed)
 	{
 		uint8_t hashInput[16]{};
 		Utils::WriteLe64(hashInput, decompressed.offset);
 		Utils::WriteLe32(hashInput + 8, decompressed.size);
 		Utils::WriteLe32(hashInput + 12, decompressed.key);
 
-		const auto hash = MurmurHash3X64_128(hashInput, sizeof(hashInput));
+		const auto hash = DecimaHash::MurmurHash3X64_128(hashInput, sizeof(hashInput));
 		Utils::WriteLe64(hashInput, hash[0] ^ decimaDataKey0);
 		Utils::WriteLe64(hashInput + 8, hash[1] ^ decimaDataKey1);
+		return ComputeMd5(hashInput, sizeof(hashInput));
+	}
 
-		uint8_t xorKey[16]{};
-		if (!ComputeMd5(hashInput, sizeof(hashInput), xorKey))
-		{
-			return false;
-		}
+	uint64_t ComputeDecimaPathHash(const std::string& normalizedPath)
+	{
+		return DecimaHash::ComputePathHash(normalizedPath.c_str(), normalizedPath.size());
+	}
 
-		for (size_t i = 0; i < size; i++)
-		{
-			bytes[i] ^= xorKey[i & 15];
-		}
-		return true;
+	uint64_t GetRequestPathHash(const DecimaArchiveReader::ReadFileRequest& request)
+	{
+		return request.pathHash != 0 ? request.pathHash : ComputeDecimaPathHash(request.normalizedPath);
 	}
 
-	uint64_t ComputeDecimaPathHash(const std::string& normalizedPath)
+	// Only built for error messages; requests made by hash have no path to show.
+	std::string DescribeStream(const std::string& normalizedPath, uint64_t streamHash)
 	{
-		std::vector<uint8_t> bytes(normalizedPath.begin(), normalizedPath.end());
-		bytes.push_back(0);
-		return MurmurHash3X64_128(bytes.data(), bytes.size())[0];
+		return normalizedPath.empty()
+			? "Decima stream with hash " + std::to_string(streamHash)
+			: "Decima stream \"" + normalizedPath + "\" (hash " + std::to_string(streamHash) + ")";
 	}
 
 	DecimaPackSpan ReadPackSpan(const uint8_t* bytes)
@@ -291,17 +308,12 @@ namespace
 		};
 	}
 
-	DecimaPackFileEntry ReadPackFileEntry(uint8_t* bytes, bool encrypted)
-	{
-		if (encrypted)
-		{
-			const uint32_t key1 = Utils::ReadLe32(bytes + 4);
-			const uint32_t key2 = Utils::ReadLe32(bytes + 28);
-			SwizzleHeaderBlock(bytes, key1, key2);
-			Utils::WriteLe32(bytes + 4, key1);
-			Utils::WriteLe32(bytes + 28, key2);
-		}
+	constexpr size_t fileEntryKeyOffset = 4;
+	constexpr size_t chunkEntryKeyOffset = 12;
 
+	// Expects an entry that SwizzleTableEntries has already decrypted.
+	DecimaPackFileEntry ReadPackFileEntry(const uint8_t* bytes)
+	{
 		return {
 			Utils::ReadLe32(bytes),
 			Utils::ReadLe32(bytes + 4),
@@ -310,21 +322,18 @@ namespace
 		};
 	}
 
-	DecimaPackChunkEntry ReadPackChunkEntry(uint8_t* bytes, bool encrypted)
+	// Expects an entry that SwizzleTableEntries has already decrypted.
+	DecimaPackChunkEntry ReadPackChunkEntry(const uint8_t* bytes, bool encrypted)
 	{
-		if (encrypted)
-		{
-			const uint32_t key1 = Utils::ReadLe32(bytes + 12);
-			const uint32_t key2 = Utils::ReadLe32(bytes + 28);
-			SwizzleHeaderBlock(bytes, key1, key2);
-			Utils::WriteLe32(bytes + 12, key1);
-			Utils::WriteLe32(bytes + 28, key2);
-		}
-
-		return {
+		DecimaPackChunkEntry chunk{
 			ReadPackSpan(bytes),
 			ReadPackSpan(bytes + 16)
 		};
+		if (encrypted)
+		{
+			chunk.dataKey = DeriveDataBlockKey(chunk.decompressed);
+		}
+		return chunk;
 	}
 
 	OodleLZDecompressFn ResolveOodleDecompress()
@@ -362,8 +371,9 @@ namespace
 	}
 
 	bool OodleDecompressChunk(
-		const std::vector<uint8_t>& compressed,
-		std::vector<uint8_t>& decompressed,
+		const uint8_t* compressed,
+		size_t compressedSize,
+		uint8_t* decompressed,
 		uint32_t expectedSize
 	)
 	{
@@ -373,12 +383,11 @@ namespace
 			return false;
 		}
 
-		decompressed.assign(expectedSize, 0);
 		const long long result = decompress(
-			compressed.data(),
-			static_cast<long long>(compressed.size()),
-			decompressed.data(),
-			static_cast<long long>(decompressed.size()),
+			compressed,
+			static_cast<long long>(compressedSize),
+			decompressed,
+			static_cast<long long>(expectedSize),
 			1,
 			1,
 			0,
@@ -393,255 +402,1460 @@ namespace
 		return result == static_cast<long long>(expectedSize);
 	}
 
-	std::wstring BuildInitialArchivePath(const std::wstring& moduleDirectory, const wchar_t* directory)
-	{
-		return moduleDirectory + L"\\" + directory + L"\\" + decimaInitialArchiveFilename;
-	}
-}
+	using ChunkDecompressFn = bool(*)(const uint8_t*, size_t, uint8_t*, uint32_t);
 
-namespace DecimaArchiveReader
-{
-	std::string BuildStreamedWemPath(uint32_t sourceId)
+	// Codec for synthetic benchmark packs, whose chunks are stored uncompressed.
+	bool StoredDecompressChunk(
+		const uint8_t* compressed,
+		size_t compressedSize,
+		uint8_t* decompressed,
+		uint32_t expectedSize
+	)
 	{
-		return "ds/sounds/streamed_wem_in_bank/generated/windows/"
-			+ std::to_string(sourceId)
-			+ ".core.stream";
+		if (compressedSize != expectedSize)
+		{
+			return false;
+		}
+		std::memcpy(decompressed, compressed, compressedSize);
+		return true;
 	}
 
-	std::wstring GetInitialArchivePath()
+	PackChunkDecodeStatus DecodePackChunk(
+		const uint8_t* compressed,
+		const DecimaPackChunkEntry& chunk,
+		bool encrypted,
+		ChunkDecompressFn decompress,
+		uint8_t* decryptScratch,
+		uint8_t* decompressed
+	)
 	{
-		const std::wstring moduleDirectory = Utils::GetCurrentModuleDirectory();
-		if (moduleDirectory.empty())
-		{
-			return {};
-		}
-		for (const wchar_t* directory : decimaInitialArchiveDirectories)
+		const uint8_t* source = compressed;
+		if (encrypted)
 		{
-			const std::wstring path = BuildInitialArchivePath(moduleDirectory, directory);
-			if (Utils::IsExistingFile(path))
-			{
-				return path;
-			}
+			SimdKernels::XorRepeatingKey16(compressed, decryptScratch, chunk.compressed.size, chunk.dataKey.data());
+			source = decryptScratch;
 		}
-		return {};
+
+		return decompress(source, chunk.compressed.size, decompressed, chunk.decompressed.size)
+			? PackChunkDecodeStatus::Success
+			: PackChunkDecodeStatus::DecompressFailed;
 	}
 
-	ReadFileResult ReadInitialArchiveFile(
-		const std::string& normalizedPath,
-		uint32_t expectedSize,
-		std::vector<uint8_t>& output
+	// Chunk bytes come straight from the mapped archive; an unreadable page raises instead of failing a read call.
+	PackChunkDecodeStatus DecodePackChunkNoUnwind(
+		const uint8_t* compressed,
+		const DecimaPackChunkEntry& chunk,
+		bool encrypted,
+		ChunkDecompressFn decompress,
+		uint8_t* decryptScratch,
+		uint8_t* decompressed
 	)
 	{
-		output.clear();
-		if (normalizedPath.empty())
-		{
-			return Fail(output, "Decima archive path is empty");
-		}
-		if (expectedSize < 16 || expectedSize > maxExtractedFileSize)
+		__try
 		{
-			return Fail(output, "expected Decima archive entry size is not valid");
+			return DecodePackChunk(compressed, chunk, encrypted, decompress, decryptScratch, decompressed);
 		}
-
-		const uint64_t streamHash = ComputeDecimaPathHash(normalizedPath);
-		const std::wstring archivePath = GetInitialArchivePath();
-		if (archivePath.empty())
+		__except (EXCEPTION_EXECUTE_HANDLER)
 		{
-			return Fail(output, "Decima Initial archive was not found");
+			return PackChunkDecodeStatus::ReadFailed;
 		}
+	}
 
-		UniqueHandle archive(CreateFileW(
-			archivePath.c_str(),
-			GENERIC_READ,
-			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-			nullptr,
-			OPEN_EXISTING,
-			FILE_ATTRIBUTE_NORMAL,
-			nullptr
-		));
-		if (!archive.IsValid())
-		{
-			return Fail(output,
-				"cannot open Decima Initial archive: " + Utils::WstringToUtf8(archivePath)
-			);
-		}
+	struct DecimaPackHeader
+	{
+		bool encrypted = false;
+		uint64_t fileEntryCount = 0;
+		uint32_t chunkEntryCount = 0;
+	};
 
-		std::array<uint8_t, 40> headerBytes{};
-		if (!Utils::ReadFileBytesAt(archive.handle, 0, headerBytes.data(), headerBytes.size()))
+	bool ReadPackHeader(
+		const MappedFile& archive,
+		const std::string& archiveName,
+		DecimaPackHeader& header,
+		std::string& error
+	)
+	{
+		std::array<uint8_t, decimaPackHeaderSize> headerBytes{};
+		if (!archive.Read(0, headerBytes.data(), headerBytes.size()))
 		{
-			return Fail(output, "failed to read Decima Initial archive header");
+			error = "failed to read Decima archive header: " + archiveName;
+			return false;
 		}
 
 		const uint32_t magic = Utils::ReadLe32(headerBytes.data());
-		const bool encrypted = magic == decimaPackMagicEncrypted;
+		header.encrypted = magic == decimaPackMagicEncrypted;
 		if (magic != decimaPackMagicPlain && magic != decimaPackMagicEncrypted)
 		{
-			return Fail(output,
-				"Decima Initial archive has unexpected magic 0x" + std::to_string(magic)
-			);
+			error = "Decima archive " + archiveName + " has unexpected magic 0x" + std::to_string(magic);
+			return false;
 		}
 
 		const uint32_t headerKey = Utils::ReadLe32(headerBytes.data() + 4);
-		if (encrypted)
+		if (header.encrypted)
 		{
 			SwizzleHeaderBlock(headerBytes.data() + 8, headerKey, headerKey + 1);
 		}
 
 		const uint64_t fileSize = Utils::ReadLe64(headerBytes.data() + 8);
 		const uint64_t dataSize = Utils::ReadLe64(headerBytes.data() + 16);
-		const uint64_t fileEntryCount = Utils::ReadLe64(headerBytes.data() + 24);
-		const uint32_t chunkEntryCount = Utils::ReadLe32(headerBytes.data() + 32);
+		header.fileEntryCount = Utils::ReadLe64(headerBytes.data() + 24);
+		header.chunkEntryCount = Utils::ReadLe32(headerBytes.data() + 32);
 		const uint32_t chunkEntrySize = Utils::ReadLe32(headerBytes.data() + 36);
 
-		LARGE_INTEGER physicalFileSize{};
+		const uint64_t tableBytes = (header.fileEntryCount + header.chunkEntryCount) * 32ull;
 		if (
-			fileEntryCount > 1000000ull
-			|| chunkEntryCount > 1000000u
+			header.fileEntryCount > 1000000ull
+			|| header.chunkEntryCount > 1000000u
 			|| chunkEntrySize != decimaPackChunkSize
-			|| !GetFileSizeEx(archive.handle, &physicalFileSize)
-			|| static_cast<uint64_t>(physicalFileSize.QuadPart) != fileSize
+			|| archive.Size() != fileSize
 			|| dataSize == 0
+			|| tableBytes > DecimaArchiveReader::maxExtractedFileSize
 		)
 		{
-			return Fail(output,
-				"Decima Initial archive header is not valid (files "
-				+ std::to_string(fileEntryCount)
-				+ ", chunks " + std::to_string(chunkEntryCount)
+			error = "Decima archive " + archiveName + " header is not valid (files "
+				+ std::to_string(header.fileEntryCount)
+				+ ", chunks " + std::to_string(header.chunkEntryCount)
 				+ ", chunk size " + std::to_string(chunkEntrySize)
-				+ ")"
-			);
+				+ ")";
+			return false;
+		}
+		return true;
+	}
+
+	// Lazily opened: only packs that actually serve a read are mapped and have their chunk table decoded.
+	struct DecimaPack
+	{
+		std::wstring relativePath{};
+		uint64_t size = 0;
+		uint64_t lastWriteTime = 0;
+		MappedFile archive{};
+		bool chunksLoaded = false;
+		bool encrypted = false;
+		ChunkDecompressFn decompress = OodleDecompressChunk;
+		std::vector<DecimaPackChunkEntry> chunks{};
+	};
+
+	// Index file layout (little endian):
+	//   u32 magic, u32 version, u32 pack count, u32 entry count
+	//   per pack: u64 size, u64 last write time, u32 path bytes, UTF-8 path relative to the game directory
+	//   per entry, sorted by hash: u64 path hash, u64 offset, u32 size, u32 pack
+	constexpr uint32_t archiveIndexMagic = 0x58444957; // "WIDX"
+	constexpr uint32_t archiveIndexVersion = 1;
+	constexpr size_t archiveIndexEntrySize = 24;
+
+	struct DecimaArchiveSetEntry
+	{
+		uint64_t hash = 0;
+		uint64_t offset = 0;
+		uint32_t size = 0;
+		uint32_t pack = 0;
+	};
+
+	// Every pack in the game's archive directories behind one path-hash index.
+	struct DecimaArchiveSet
+	{
+		std::wstring gameDirectory{};
+		std::vector<std::unique_ptr<DecimaPack>> packs{};
+		// Entries stay in their serialized form, read straight from the mapped index file when it was valid.
+		MappedFile indexFile{};
+		std::vector<uint8_t> builtIndex{};
+		const uint8_t* entries = nullptr;
+		size_t entryCount = 0;
+	};
+
+	std::mutex archiveSetMutex;
+	std::unique_ptr<DecimaArchiveSet> archiveSet;
+
+	// The Initial archive comes first so its entries win over duplicates in other packs.
+	std::vector<std::unique_ptr<DecimaPack>> EnumeratePacks(const std::wstring& gameDirectory)
+	{
+		std::vector<std::unique_ptr<DecimaPack>> packs;
+		for (const wchar_t* directory : decimaArchiveDirectories)
+		{
+			std::error_code ec;
+			std::vector<std::wstring> names;
+			for (
+				std::filesystem::directory_iterator it(gameDirectory + L"\\" + directory, ec), end;
+				!ec && it != end;
+				it.increment(ec)
+			)
+			{
+				std::error_code entryEc;
+				const std::filesystem::path& path = it->path();
+				if (it->is_regular_file(entryEc) && _wcsicmp(path.extension().wstring().c_str(), L".bin") == 0)
+				{
+					names.push_back(path.filename().wstring());
+				}
+			}
+
+			std::sort(names.begin(), names.end());
+			for (const std::wstring& name : names)
+			{
+				auto pack = std::make_unique<DecimaPack>();
+				pack->relativePath = std::wstring(directory) + L"\\" + name;
+				const std::wstring packPath = gameDirectory + L"\\" + pack->relativePath;
+				if (Utils::GetFileSizeAndWriteTime(packPath, pack->size, pack->lastWriteTime))
+				{
+					packs.push_back(std::move(pack));
+				}
+			}
 		}
 
-		const uint64_t fileTableBytes = fileEntryCount * 32ull;
-		const uint64_t chunkTableBytes = static_cast<uint64_t>(chunkEntryCount) * 32ull;
-		const uint64_t tableBytes64 = fileTableBytes + chunkTableBytes;
-		if (tableBytes64 > maxExtractedFileSize)
+		std::stable_partition(
+			packs.begin(),
+			packs.end(),
+			[](const std::unique_ptr<DecimaPack>& pack)
+			{
+				const size_t slash = pack->relativePath.find_last_of(L'\\');
+				return _wcsicmp(pack->relativePath.c_str() + slash + 1, decimaInitialArchiveFilename) == 0;
+			}
+		);
+		return packs;
+	}
+
+	std::wstring GetArchiveIndexPath(const std::wstring& gameDirectory)
+	{
+		return gameDirectory + L"\\" + archiveIndexFilename;
+	}
+
+	// Accepts the index file only if it describes exactly the packs on disk, down to their sizes and write times.
+	bool LoadArchiveIndexFile(DecimaArchiveSet& set)
+	{
+		MappedFile& file = set.indexFile;
+		if (!file.Open(GetArchiveIndexPath(set.gameDirectory)) || file.Size() < 16)
 		{
-			return Fail(output,
-				"Decima Initial archive table is too large ("
-				+ std::to_string(tableBytes64)
-				+ " bytes)"
-			);
+			file.Close();
+			return false;
 		}
 
-		std::vector<uint8_t> tableBytes(static_cast<size_t>(tableBytes64));
-		if (!Utils::ReadFileBytesAt(archive.handle, headerBytes.size(), tableBytes.data(), tableBytes.size()))
+		std::vector<uint8_t> header(16);
+		if (
+			!file.Read(0, header.data(), header.size())
+			|| Utils::ReadLe32(header.data()) != archiveIndexMagic
+			|| Utils::ReadLe32(header.data() + 4) != archiveIndexVersion
+			|| Utils::ReadLe32(header.data() + 8) != set.packs.size()
+		)
 		{
-			return Fail(output, "failed to read Decima Initial archive tables");
+			file.Close();
+			return false;
 		}
 
-		DecimaPackFileEntry streamEntry{};
-		bool foundStreamEntry = false;
-		for (uint64_t i = 0; i < fileEntryCount; i++)
+		const size_t entryCount = Utils::ReadLe32(header.data() + 12);
+		uint64_t offset = 16;
+		for (const std::unique_ptr<DecimaPack>& pack : set.packs)
 		{
-			DecimaPackFileEntry entry = ReadPackFileEntry(
-				tableBytes.data() + static_cast<size_t>(i * 32ull),
-				encrypted
-			);
-			if (entry.hash == streamHash)
+			uint8_t record[20]{};
+			if (!file.Read(offset, record, sizeof(record)))
+			{
+				file.Close();
+				return false;
+			}
+
+			const uint32_t pathBytes = Utils::ReadLe32(record + 16);
+			std::string path(pathBytes, '\0');
+			if (
+				Utils::ReadLe64(record) != pack->size
+				|| Utils::ReadLe64(record + 8) != pack->lastWriteTime
+				|| pathBytes > 1024
+				|| !file.Read(offset + sizeof(record), path.data(), path.size())
+				|| path != Utils::WstringToUtf8(pack->relativePath)
+			)
 			{
-				streamEntry = entry;
-				foundStreamEntry = true;
-				break;
+				file.Close();
+				return false;
 			}
+			offset += sizeof(record) + pathBytes;
 		}
 
-		if (!foundStreamEntry)
+		if (file.Size() != offset + static_cast<uint64_t>(entryCount) * archiveIndexEntrySize)
 		{
-			return Fail(output,
-				"could not find Decima stream \"" + normalizedPath
-				+ "\" (hash " + std::to_string(streamHash) + ")"
-			);
+			file.Close();
+			return false;
 		}
 
-		if (streamEntry.span.size != expectedSize)
+		set.entries = file.Data() + offset;
+		set.entryCount = entryCount;
+		return true;
+	}
+
+	// Runs work(item, worker) for every item on a pool of at most maxWorkers threads that includes the calling
+	// thread. worker is below maxWorkers and unique among the running threads, so it can index per-thread scratch.
+	template <typename Work>
+	void RunOnWorkerPool(size_t itemCount, size_t maxWorkers, Work work)
+	{
+		std::atomic<size_t> nextItem{ 0 };
+		auto worker = [&](size_t workerIndex)
 		{
-			return Fail(output,
-				"Decima stream \"" + normalizedPath
-				+ "\" size mismatch (archive "
-				+ std::to_string(streamEntry.span.size)
-				+ ", expected " + std::to_string(expectedSize)
-				+ ")"
-			);
+			for (size_t i = nextItem.fetch_add(1); i < itemCount; i = nextItem.fetch_add(1))
+			{
+				work(i, workerIndex);
+			}
+		};
+
+		const size_t hardwareThreads = (std::max)(1u, std::thread::hardware_concurrency());
+		const size_t workerCount = (std::min)({ itemCount, hardwareThreads, maxWorkers });
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < workerCount; i++)
+		{
+			workers.emplace_back(worker, i);
+		}
+		worker(0);
+		for (std::thread& thread : workers)
+		{
+			thread.join();
+		}
+	}
+
+	struct PackFileTable
+	{
+		MappedFile archive{};
+		DecimaPackHeader header{};
+		bool opened = false;
+		std::atomic<bool> failed{ false };
+		// Where this pack's entries start in the merged entry list.
+		size_t firstEntry = 0;
+	};
+
+	struct PackFileTableSlice
+	{
+		size_t table = 0;
+		uint64_t begin = 0;
+		uint64_t end = 0;
+	};
+
+	bool OpenPackFileTable(const std::wstring& gameDirectory, const DecimaPack& pack, PackFileTable& table)
+	{
+		std::string error;
+		const std::string archiveName = Utils::WstringToUtf8(pack.relativePath);
+		if (!table.archive.Open(gameDirectory + L"\\" + pack.relativePath))
+		{
+			error = "cannot open Decima archive: " + archiveName;
+		}
+		else if (
+			ReadPackHeader(table.archive, archiveName, table.header, error)
+			&& !table.archive.Contains(decimaPackHeaderSize, table.header.fileEntryCount * 32ull)
+		)
+		{
+			error = "Decima archive " + archiveName + " is too small for its file table";
+		}
+
+		if (!error.empty())
+		{
+			Logging::Write(logPrefix, "Leaving %s out of the archive index: %s", archiveName.c_str(), error.c_str());
 		}
+		return error.empty();
+	}
 
-		uint8_t* chunkTable = tableBytes.data() + static_cast<size_t>(fileTableBytes);
-		std::vector<DecimaPackChunkEntry> chunks;
-		chunks.reserve(chunkEntryCount);
-		for (uint32_t i = 0; i < chunkEntryCount; i++)
+	// Entries are copied out of the view a batch at a time, decrypted in that small buffer and reduced to what
+	// the index keeps.
+	bool DecodePackFileTableSlice(
+		const PackFileTable& table,
+		uint32_t packIndex,
+		uint64_t begin,
+		uint64_t end,
+		DecimaArchiveSetEntry* entries
+	)
+	{
+		std::array<uint8_t, tableDecodeBatchEntries * 32> tableBytes{};
+		for (uint64_t base = begin; base < end; base += tableDecodeBatchEntries)
 		{
-			chunks.push_back(ReadPackChunkEntry(
-				chunkTable + static_cast<size_t>(i) * 32ull,
-				encrypted
-			));
+			const size_t batchCount = static_cast<size_t>(
+				(std::min)(end - base, uint64_t{ tableDecodeBatchEntries })
+			);
+			if (!table.archive.Read(decimaPackHeaderSize + base * 32ull, tableBytes.data(), batchCount * 32))
+			{
+				return false;
+			}
+			if (table.header.encrypted)
+			{
+				SwizzleTableEntries(tableBytes.data(), batchCount, fileEntryKeyOffset);
+			}
+
+			for (size_t i = 0; i < batchCount; i++)
+			{
+				const DecimaPackFileEntry file = ReadPackFileEntry(tableBytes.data() + i * 32);
+				entries[static_cast<size_t>(base) + i] = { file.hash, file.span.offset, file.span.size, packIndex };
+			}
 		}
+		return true;
+	}
 
-		output.assign(streamEntry.span.size, 0);
-		const uint64_t fileStart = streamEntry.span.offset;
-		const uint64_t fileEnd = fileStart + streamEntry.span.size;
-		size_t copiedBytes = 0;
+	// Decodes every pack's file table on a small pool, merges them and tries to persist the result.
+	bool BuildArchiveIndex(DecimaArchiveSet& set, std::string& error)
+	{
+		std::vector<PackFileTable> tables(set.packs.size());
+		RunOnWorkerPool(
+			tables.size(),
+			maxChunkWorkers,
+			[&](size_t i, size_t)
+			{
+				tables[i].opened = OpenPackFileTable(set.gameDirectory, *set.packs[i], tables[i]);
+			}
+		);
 
-		for (const DecimaPackChunkEntry& chunk : chunks)
+		// Every slice decodes straight into its place in the merged list. Big tables are split so a single
+		// large pack does not leave the rest of the pool idle.
+		std::vector<PackFileTableSlice> slices;
+		size_t entryCount = 0;
+		for (size_t i = 0; i < tables.size(); i++)
 		{
-			const uint64_t chunkStart = chunk.decompressed.offset;
-			const uint64_t chunkEnd = chunkStart + chunk.decompressed.size;
-			if (chunkEnd <= fileStart || chunkStart >= fileEnd)
+			const uint64_t tableEntryCount = tables[i].opened ? tables[i].header.fileEntryCount : 0;
+			tables[i].firstEntry = entryCount;
+			entryCount += static_cast<size_t>(tableEntryCount);
+			for (uint64_t begin = 0; begin < tableEntryCount; begin += fileTableSliceEntries)
 			{
-				continue;
+				slices.push_back({ i, begin, (std::min)(tableEntryCount, begin + fileTableSliceEntries) });
 			}
+		}
 
-			if (
-				chunk.decompressed.size == 0
-				|| chunk.decompressed.size > decimaPackChunkSize
-				|| chunk.compressed.size == 0
-				|| chunk.compressed.size > decimaPackChunkSize * 2u
-			)
+		std::vector<DecimaArchiveSetEntry> entries(entryCount);
+		RunOnWorkerPool(
+			slices.size(),
+			maxChunkWorkers,
+			[&](size_t i, size_t)
 			{
-				return Fail(output,
-					"Decima chunk metadata is not valid (compressed "
-					+ std::to_string(chunk.compressed.size)
-					+ ", decompressed " + std::to_string(chunk.decompressed.size)
-					+ ")",
-					copiedBytes
-				);
+				const PackFileTableSlice& slice = slices[i];
+				PackFileTable& table = tables[slice.table];
+				const uint32_t packIndex = static_cast<uint32_t>(slice.table);
+				if (!DecodePackFileTableSlice(table, packIndex, slice.begin, slice.end, &entries[table.firstEntry]))
+				{
+					table.failed = true;
+				}
 			}
+		);
 
-			std::vector<uint8_t> compressed(chunk.compressed.size);
-			if (!Utils::ReadFileBytesAt(archive.handle, chunk.compressed.offset, compressed.data(), compressed.size()))
+		bool complete = true;
+		for (size_t i = 0; i < tables.size(); i++)
+		{
+			if (tables[i].opened && tables[i].failed)
 			{
-				return Fail(output, "failed to read Decima archive chunk", copiedBytes);
+				Logging::Write(logPrefix,
+					"Leaving %s out of the archive index: failed to read its file table",
+					Utils::WstringToUtf8(set.packs[i]->relativePath).c_str()
+				);
 			}
+			complete = complete && tables[i].opened && !tables[i].failed;
+		}
 
-			if (encrypted && !SwizzleDataBlock(compressed.data(), compressed.size(), chunk.decompressed))
+		// A failed slice may have left its part of the table's range unwritten, so drop the table's whole range
+		// rather than trusting each entry's pack field. Going backwards keeps the earlier ranges where they are.
+		for (size_t i = tables.size(); i-- > 0;)
+		{
+			if (tables[i].opened && tables[i].failed)
 			{
-				return Fail(output, "failed to decrypt Decima archive chunk", copiedBytes);
+				const auto first = entries.begin() + static_cast<std::ptrdiff_t>(tables[i].firstEntry);
+				entries.erase(first, first + static_cast<std::ptrdiff_t>(tables[i].header.fileEntryCount));
 			}
+		}
+		if (entries.empty())
+		{
+			error = "no Decima archive could be indexed";
+			return false;
+		}
 
-			std::vector<uint8_t> decompressed;
-			if (!OodleDecompressChunk(compressed, decompressed, chunk.decompressed.size))
+		// Pack indices follow priority order, so the first entry of each hash is the one to keep.
+		std::sort(
+			entries.begin(),
+			entries.end(),
+			[](const DecimaArchiveSetEntry& lhs, const DecimaArchiveSetEntry& rhs)
 			{
-				return Fail(output, "failed to decompress Decima archive chunk", copiedBytes);
+				return lhs.hash != rhs.hash ? lhs.hash < rhs.hash : lhs.pack < rhs.pack;
 			}
+		);
+		entries.erase(
+			std::unique(
+				entries.begin(),
+				entries.end(),
+				[](const DecimaArchiveSetEntry& lhs, const DecimaArchiveSetEntry& rhs)
+				{
+					return lhs.hash == rhs.hash;
+				}
+			),
+			entries.end()
+		);
 
-			const uint64_t copyStart = (std::max)(fileStart, chunkStart);
-			const uint64_t copyEnd = (std::min)(fileEnd, chunkEnd);
-			const size_t sourceOffset = static_cast<size_t>(copyStart - chunkStart);
-			const size_t targetOffset = static_cast<size_t>(copyStart - fileStart);
-			const size_t copySize = static_cast<size_t>(copyEnd - copyStart);
-			std::memcpy(output.data() + targetOffset, decompressed.data() + sourceOffset, copySize);
-			copiedBytes += copySize;
+		std::vector<uint8_t>& bytes = set.builtIndex;
+		bytes.clear();
+		Utils::AppendLe32(bytes, archiveIndexMagic);
+		Utils::AppendLe32(bytes, archiveIndexVersion);
+		Utils::AppendLe32(bytes, static_cast<uint32_t>(set.packs.size()));
+		Utils::AppendLe32(bytes, static_cast<uint32_t>(entries.size()));
+		for (const std::unique_ptr<DecimaPack>& pack : set.packs)
+		{
+			const std::string path = Utils::WstringToUtf8(pack->relativePath);
+			Utils::AppendLe64(bytes, pack->size);
+			Utils::AppendLe64(bytes, pack->lastWriteTime);
+			Utils::AppendLe32(bytes, static_cast<uint32_t>(path.size()));
+			bytes.insert(bytes.end(), path.begin(), path.end());
 		}
 
-		if (copiedBytes != output.size())
+		const size_t entriesOffset = bytes.size();
+		bytes.resize(entriesOffset + entries.size() * archiveIndexEntrySize);
+		uint8_t* entryBytes = bytes.data() + entriesOffset;
+		for (const DecimaArchiveSetEntry& entry : entries)
 		{
-			return Fail(output,
-				"Decima archive extraction copied "
-				+ std::to_string(copiedBytes)
-				+ " of " + std::to_string(output.size())
-				+ " bytes",
-				copiedBytes
-			);
+			Utils::WriteLe64(entryBytes, entry.hash);
+			Utils::WriteLe64(entryBytes + 8, entry.offset);
+			Utils::WriteLe32(entryBytes + 16, entry.size);
+			Utils::WriteLe32(entryBytes + 20, entry.pack);
+			entryBytes += archiveIndexEntrySize;
+		}
+
+		// A read-only game directory only costs the next launch a rebuild. An index missing a pack that could not
+		// be read this time is only used for this session, so the next launch gets another try at that pack.
+		if (complete)
+		{
+			Utils::WriteFileBytesWide(GetArchiveIndexPath(set.gameDirectory), bytes);
+		}
+
+		set.entries = bytes.data() + entriesOffset;
+		set.entryCount = entries.size();
+		return true;
+	}
+
+	bool FindArchiveSetEntry(const DecimaArchiveSet& set, uint64_t hash, DecimaArchiveSetEntry& entry)
+	{
+		size_t low = 0;
+		size_t high = set.entryCount;
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (Utils::ReadLe64(set.entries + middle * archiveIndexEntrySize) < hash)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		if (low == set.entryCount)
+		{
+			return false;
+		}
+
+		const uint8_t* record = set.entries + low * archiveIndexEntrySize;
+		if (Utils::ReadLe64(record) != hash)
+		{
+			return false;
+		}
+		entry = {
+			hash,
+			Utils::ReadLe64(record + 8),
+			Utils::ReadLe32(record + 16),
+			Utils::ReadLe32(record + 20)
+		};
+		return entry.pack < set.packs.size();
+	}
+
+	// Caller must hold archiveSetMutex.
+	bool LoadPackChunks(const DecimaArchiveSet& set, DecimaPack& pack, std::string& error)
+	{
+		if (pack.chunksLoaded)
+		{
+			return true;
+		}
+
+		const std::string archiveName = Utils::WstringToUtf8(pack.relativePath);
+		if (!pack.archive.Open(set.gameDirectory + L"\\" + pack.relativePath))
+		{
+			error = "cannot open Decima archive: " + archiveName;
+			return false;
+		}
+		if (pack.archive.Size() != pack.size)
+		{
+			error = "Decima archive " + archiveName + " changed since it was indexed";
+			pack.archive.Close();
+			return false;
+		}
+
+		DecimaPackHeader header{};
+		if (!ReadPackHeader(pack.archive, archiveName, header, error))
+		{
+			pack.archive.Close();
+			return false;
+		}
+
+		// Only the chunk table is needed here; file lookups go through the archive set index.
+		std::vector<uint8_t> tableBytes(static_cast<size_t>(header.chunkEntryCount) * 32u);
+		if (!pack.archive.Read(
+			decimaPackHeaderSize + header.fileEntryCount * 32ull,
+			tableBytes.data(),
+			tableBytes.size()
+		))
+		{
+			error = "failed to read Decima archive chunk table: " + archiveName;
+			pack.archive.Close();
+			return false;
+		}
+
+		pack.encrypted = header.encrypted;
+		if (pack.encrypted)
+		{
+			SwizzleTableEntries(tableBytes.data(), header.chunkEntryCount, chunkEntryKeyOffset);
+		}
+		pack.chunks.reserve(header.chunkEntryCount);
+		for (uint32_t i = 0; i < header.chunkEntryCount; i++)
+		{
+			pack.chunks.push_back(ReadPackChunkEntry(tableBytes.data() + static_cast<size_t>(i) * 32u, pack.encrypted));
+		}
+
+		// Sorted chunks turn range lookups into binary searches instead of full scans.
+		std::sort(
+			pack.chunks.begin(),
+			pack.chunks.end(),
+			[](const DecimaPackChunkEntry& lhs, const DecimaPackChunkEntry& rhs)
+			{
+				return lhs.decompressed.offset < rhs.decompressed.offset;
+			}
+		);
+		pack.chunksLoaded = true;
+		return true;
+	}
+
+	// Returns the first chunk whose decompressed span ends after the given offset.
+	std::vector<DecimaPackChunkEntry>::const_iterator FindFirstPackChunk(
+		const DecimaPack& pack,
+		uint64_t decompressedOffset
+	)
+	{
+		return std::partition_point(
+			pack.chunks.begin(),
+			pack.chunks.end(),
+			[decompressedOffset](const DecimaPackChunkEntry& chunk)
+			{
+				return chunk.decompressed.offset + chunk.decompressed.size <= decompressedOffset;
+			}
+		);
+	}
+
+	struct PackExtractTarget
+	{
+		uint64_t start = 0;
+		uint64_t end = 0;
+		uint8_t* output = nullptr;
+		std::atomic<size_t> copiedBytes{ 0 };
+		PackChunkDecodeStatus status = PackChunkDecodeStatus::Success;
+	};
+
+	// One decode of a chunk, scattered to every target whose span overlaps it.
+	struct PackChunkTask
+	{
+		const DecimaPack* pack = nullptr;
+		uint64_t cacheKey = 0;
+		const DecimaPackChunkEntry* chunk = nullptr;
+		std::vector<PackExtractTarget*> targets{};
+	};
+
+	struct PackChunkScratch
+	{
+		std::vector<uint8_t> decrypt{};
+		std::vector<uint8_t> edge{};
+	};
+
+	uint64_t MakeChunkCacheKey(uint32_t packIndex, size_t chunkIndex)
+	{
+		return (static_cast<uint64_t>(packIndex) << 32) | static_cast<uint32_t>(chunkIndex);
+	}
+
+	// Decompressed chunks keyed by pack and chunk index, evicted least recently used first.
+	class DecimaChunkCache
+	{
+	public:
+		bool Contains(uint64_t cacheKey) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return entries_.count(cacheKey) != 0;
+		}
+
+		std::shared_ptr<const std::vector<uint8_t>> Find(uint64_t cacheKey)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = entries_.find(cacheKey);
+			if (it == entries_.end())
+			{
+				misses_++;
+				return nullptr;
+			}
+
+			hits_++;
+			recency_.splice(recency_.begin(), recency_, it->second.recency);
+			return it->second.bytes;
+		}
+
+		void Insert(uint64_t cacheKey, const uint8_t* bytes, size_t size, size_t budget)
+		{
+			if (size > budget)
+			{
+				return;
+			}
+
+			auto copy = std::make_shared<const std::vector<uint8_t>>(bytes, bytes + size);
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (entries_.count(cacheKey) != 0)
+			{
+				return;
+			}
+
+			while (bytes_ + size > budget && !recency_.empty())
+			{
+				auto victim = entries_.find(recency_.back());
+				bytes_ -= victim->second.bytes->size();
+				entries_.erase(victim);
+				recency_.pop_back();
+				evictions_++;
+			}
+
+			recency_.push_front(cacheKey);
+			entries_.emplace(cacheKey, Entry{ std::move(copy), recency_.begin() });
+			bytes_ += size;
+		}
+
+		DecimaArchiveReader::ChunkCacheStats GetStats(size_t budget) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return { hits_, misses_, evictions_, bytes_, budget };
+		}
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<const std::vector<uint8_t>> bytes{};
+			std::list<uint64_t>::iterator recency{};
+		};
+
+		mutable std::mutex mutex_;
+		std::list<uint64_t> recency_;
+		std::unordered_map<uint64_t, Entry> entries_;
+		size_t bytes_ = 0;
+		uint64_t hits_ = 0;
+		uint64_t misses_ = 0;
+		uint64_t evictions_ = 0;
+	};
+
+	DecimaChunkCache archiveChunkCache;
+
+	size_t GetChunkCacheBudget()
+	{
+		return static_cast<size_t>(ModConfiguration::archiveChunkCacheSizeMB) * 1024u * 1024u;
+	}
+
+	// Caller must hold archiveSetMutex.
+	bool PlanPackExtractTarget(
+		DecimaArchiveSet& set,
+		const DecimaArchiveReader::ReadFileRequest& request,
+		PackExtractTarget& target,
+		std::vector<PackChunkTask>& chunkTasks,
+		std::string& error
+	)
+	{
+		const uint64_t streamHash = GetRequestPathHash(request);
+		DecimaArchiveSetEntry streamEntry{};
+		if (!FindArchiveSetEntry(set, streamHash, streamEntry))
+		{
+			error = "could not find " + DescribeStream(request.normalizedPath, streamHash);
+			return false;
+		}
+
+		if (request.expectedSize != 0 && streamEntry.size != request.expectedSize)
+		{
+			error = DescribeStream(request.normalizedPath, streamHash)
+				+ " size mismatch (archive "
+				+ std::to_string(streamEntry.size)
+				+ ", expected " + std::to_string(request.expectedSize)
+				+ ")";
+			return false;
+		}
+
+		const bool rangeRead = request.rangeLength != 0;
+		if (rangeRead && static_cast<uint64_t>(request.rangeOffset) + request.rangeLength > streamEntry.size)
+		{
+			error = "requested range of " + DescribeStream(request.normalizedPath, streamHash)
+				+ " lies outside the entry (offset "
+				+ std::to_string(request.rangeOffset)
+				+ ", length " + std::to_string(request.rangeLength)
+				+ ", entry " + std::to_string(streamEntry.size)
+				+ ")";
+			return false;
+		}
+
+		DecimaPack& pack = *set.packs[streamEntry.pack];
+		if (!LoadPackChunks(set, pack, error))
+		{
+			return false;
+		}
+
+		// Only the chunks covering the requested bytes are planned, so a header probe costs a chunk or two.
+		target.start = streamEntry.offset + (rangeRead ? request.rangeOffset : 0u);
+		target.end = target.start + (rangeRead ? request.rangeLength : streamEntry.size);
+		for (
+			auto chunkIt = FindFirstPackChunk(pack, target.start);
+			chunkIt != pack.chunks.end() && chunkIt->decompressed.offset < target.end;
+			++chunkIt
+		)
+		{
+			const DecimaPackChunkEntry& chunk = *chunkIt;
+			if (chunk.decompressed.offset + chunk.decompressed.size <= target.start)
+			{
+				continue;
+			}
+
+			if (
+				chunk.decompressed.size == 0
+				|| chunk.decompressed.size > decimaPackChunkSize
+				|| chunk.compressed.size == 0
+				|| chunk.compressed.size > decimaPackChunkSize * 2u
+			)
+			{
+				error = "Decima chunk metadata is not valid (compressed "
+					+ std::to_string(chunk.compressed.size)
+					+ ", decompressed " + std::to_string(chunk.decompressed.size)
+					+ ")";
+				return false;
+			}
+
+			if (!pack.archive.Contains(chunk.compressed.offset, chunk.compressed.size))
+			{
+				error = "Decima archive chunk lies outside the archive";
+				return false;
+			}
+
+			const size_t chunkIndex = static_cast<size_t>(chunkIt - pack.chunks.begin());
+			chunkTasks.push_back({ &pack, MakeChunkCacheKey(streamEntry.pack, chunkIndex), &chunk, { &target } });
+		}
+		return true;
+	}
+
+	// Chunks are independent, so they are decoded on a small pool and each worker writes its slices of the outputs.
+	void ExtractPackChunks(DecimaChunkCache& cache, size_t cacheBudget, const std::vector<PackChunkTask>& tasks)
+	{
+		std::mutex failureMutex;
+
+		// Keeps up to chunkPrefetchDepth compressed ranges paging in while earlier chunks are being decoded.
+		auto prefetchTask = [&](size_t taskIndex)
+		{
+			if (taskIndex >= tasks.size())
+			{
+				return;
+			}
+
+			const PackChunkTask& task = tasks[taskIndex];
+			if (cacheBudget == 0 || !cache.Contains(task.cacheKey))
+			{
+				task.pack->archive.Prefetch(task.chunk->compressed.offset, task.chunk->compressed.size);
+			}
+		};
+		for (size_t i = 0; i < chunkPrefetchDepth; i++)
+		{
+			prefetchTask(i);
+		}
+
+		// Scratch buffers are allocated on first use: plain packs never decrypt, and only chunks straddling a file
+		// edge or shared between files need staging.
+		std::vector<PackChunkScratch> scratch(maxChunkWorkers);
+		RunOnWorkerPool(
+			tasks.size(),
+			maxChunkWorkers,
+			[&](size_t i, size_t workerIndex)
+			{
+				std::vector<uint8_t>& decryptScratch = scratch[workerIndex].decrypt;
+				std::vector<uint8_t>& edgeScratch = scratch[workerIndex].edge;
+
+				prefetchTask(i + chunkPrefetchDepth);
+
+				const PackChunkTask& task = tasks[i];
+				const DecimaPack& pack = *task.pack;
+				const DecimaPackChunkEntry& chunk = *task.chunk;
+				const uint64_t chunkStart = chunk.decompressed.offset;
+				const uint64_t chunkEnd = chunkStart + chunk.decompressed.size;
+
+				PackExtractTarget* directTarget = nullptr;
+				const uint8_t* decoded = nullptr;
+				std::shared_ptr<const std::vector<uint8_t>> cached;
+				if (cacheBudget != 0)
+				{
+					cached = cache.Find(task.cacheKey);
+				}
+
+				if (cached)
+				{
+					decoded = cached->data();
+				}
+				else
+				{
+					if (
+						task.targets.size() == 1
+						&& chunkStart >= task.targets[0]->start
+						&& chunkEnd <= task.targets[0]->end
+					)
+					{
+						directTarget = task.targets[0];
+					}
+					else if (edgeScratch.empty())
+					{
+						edgeScratch.resize(decimaPackChunkSize);
+					}
+					if (pack.encrypted && decryptScratch.empty())
+					{
+						decryptScratch.resize(decimaPackChunkSize * 2u);
+					}
+
+					uint8_t* destination = directTarget
+						? directTarget->output + static_cast<size_t>(chunkStart - directTarget->start)
+						: edgeScratch.data();
+					const PackChunkDecodeStatus status = DecodePackChunkNoUnwind(
+						pack.archive.Data() + chunk.compressed.offset,
+						chunk,
+						pack.encrypted,
+						pack.decompress,
+						decryptScratch.data(),
+						destination
+					);
+					if (status != PackChunkDecodeStatus::Success)
+					{
+						std::lock_guard<std::mutex> lock(failureMutex);
+						for (PackExtractTarget* target : task.targets)
+						{
+							if (target->status == PackChunkDecodeStatus::Success)
+							{
+								target->status = status;
+							}
+						}
+						return;
+					}
+
+					decoded = destination;
+					if (cacheBudget != 0)
+					{
+						cache.Insert(task.cacheKey, decoded, chunk.decompressed.size, cacheBudget);
+					}
+				}
+
+				for (PackExtractTarget* target : task.targets)
+				{
+					const uint64_t copyStart = (std::max)(target->start, chunkStart);
+					const uint64_t copyEnd = (std::min)(target->end, chunkEnd);
+					const size_t copySize = static_cast<size_t>(copyEnd - copyStart);
+					if (target != directTarget)
+					{
+						std::memcpy(
+							target->output + static_cast<size_t>(copyStart - target->start),
+							decoded + static_cast<size_t>(copyStart - chunkStart),
+							copySize
+						);
+					}
+					target->copiedBytes.fetch_add(copySize);
+				}
+			}
+		);
+	}
+
+	constexpr uint32_t benchmarkChunkCount = 32;
+	constexpr uint32_t benchmarkLargeFileCount = 4;
+	constexpr uint32_t benchmarkSmallFileSize = 1024;
+	constexpr size_t benchmarkLookupCount = 100000;
+
+	std::string BuildBenchmarkPath(uint32_t fileIndex)
+	{
+		return "walkingman/benchmark/" + std::to_string(fileIndex) + ".core";
+	}
+
+	// Uses the one-entry scalar swizzle rather than the batched table path, so the benchmark also catches a
+	// batched decrypt that disagrees with it.
+	void EncryptPackTableEntry(uint8_t* bytes, size_t key1Offset)
+	{
+		const uint32_t key1 = Utils::ReadLe32(bytes + key1Offset);
+		const uint32_t key2 = Utils::ReadLe32(bytes + 28);
+		SwizzleHeaderBlock(bytes, key1, key2);
+		Utils::WriteLe32(bytes + key1Offset, key1);
+		Utils::WriteLe32(bytes + 28, key2);
+	}
+
+	void AppendPackSpan(std::vector<uint8_t>& bytes, uint64_t offset, uint32_t size, uint32_t key)
+	{
+		Utils::AppendLe64(bytes, offset);
+		Utils::AppendLe32(bytes, size);
+		Utils::AppendLe32(bytes, key);
+	}
+
+	// Writes a pack in the game's layout whose chunks are stored rather than Oodle-compressed. The first few
+	// entries cover the data region end to end for throughput; the rest are small spans that only feed lookups.
+	bool WriteSyntheticPack(const std::wstring& path, uint32_t fileCount, bool encrypted)
+	{
+		const uint64_t dataSize = static_cast<uint64_t>(benchmarkChunkCount) * decimaPackChunkSize;
+		const uint64_t tableSize = (static_cast<uint64_t>(fileCount) + benchmarkChunkCount) * 32u;
+		const uint64_t dataStart = decimaPackHeaderSize + tableSize;
+		const uint64_t largeFileSize = dataSize / benchmarkLargeFileCount;
+
+		std::vector<uint8_t> bytes;
+		bytes.reserve(static_cast<size_t>(dataStart + dataSize));
+		const uint32_t headerKey = 0x5eed1234;
+		Utils::AppendLe32(bytes, encrypted ? decimaPackMagicEncrypted : decimaPackMagicPlain);
+		Utils::AppendLe32(bytes, headerKey);
+		Utils::AppendLe64(bytes, dataStart + dataSize);
+		Utils::AppendLe64(bytes, dataSize);
+		Utils::AppendLe64(bytes, fileCount);
+		Utils::AppendLe32(bytes, benchmarkChunkCount);
+		Utils::AppendLe32(bytes, decimaPackChunkSize);
+		if (encrypted)
+		{
+			SwizzleHeaderBlock(bytes.data() + 8, headerKey, headerKey + 1);
+		}
+
+		uint64_t state = 0x9e3779b97f4a7c15ull;
+		for (uint32_t i = 0; i < fileCount; i++)
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			const bool large = i < benchmarkLargeFileCount;
+			const uint64_t offset = large
+				? i * largeFileSize
+				: (state >> 16) % (dataSize - benchmarkSmallFileSize);
+			const size_t entryOffset = bytes.size();
+			Utils::AppendLe32(bytes, i);
+			Utils::AppendLe32(bytes, static_cast<uint32_t>(state));
+			Utils::AppendLe64(bytes, ComputeDecimaPathHash(BuildBenchmarkPath(i)));
+			AppendPackSpan(bytes, offset, large ? static_cast<uint32_t>(largeFileSize) : benchmarkSmallFileSize, i);
+			if (encrypted)
+			{
+				EncryptPackTableEntry(bytes.data() + entryOffset, fileEntryKeyOffset);
+			}
+		}
+
+		std::vector<DecimaPackSpan> decompressedSpans;
+		for (uint32_t i = 0; i < benchmarkChunkCount; i++)
+		{
+			const DecimaPackSpan decompressed{ static_cast<uint64_t>(i) * decimaPackChunkSize, decimaPackChunkSize, i };
+			decompressedSpans.push_back(decompressed);
+			const size_t entryOffset = bytes.size();
+			AppendPackSpan(bytes, decompressed.offset, decompressed.size, decompressed.key);
+			AppendPackSpan(bytes, dataStart + decompressed.offset, decimaPackChunkSize, ~i);
+			if (encrypted)
+			{
+				EncryptPackTableEntry(bytes.data() + entryOffset, chunkEntryKeyOffset);
+			}
+		}
+
+		for (const DecimaPackSpan& decompressed : decompressedSpans)
+		{
+			const size_t chunkOffset = bytes.size();
+			for (uint32_t i = 0; i < decompressed.size; i++)
+			{
+				bytes.push_back(static_cast<uint8_t>((decompressed.offset + i) * 2654435761u >> 24));
+			}
+			if (encrypted)
+			{
+				const std::array<uint8_t, 16> key = DeriveDataBlockKey(decompressed);
+				uint8_t* chunk = bytes.data() + chunkOffset;
+				SimdKernels::XorRepeatingKey16(chunk, chunk, decompressed.size, key.data());
+			}
+		}
+
+		return Utils::WriteFileBytesWide(path, bytes);
+	}
+
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void RunPackBenchmark(const std::wstring& directory, uint32_t fileCount, bool encrypted)
+	{
+		const std::wstring packName = L"benchmark_" + std::to_wstring(fileCount)
+			+ (encrypted ? L"_encrypted.bin" : L"_plain.bin");
+		const char* variant = encrypted ? "encrypted" : "plain";
+		if (!WriteSyntheticPack(directory + L"\\" + packName, fileCount, encrypted))
+		{
+			Logging::Write(logPrefix, "Benchmark %u/%s: could not write synthetic pack", fileCount, variant);
+			return;
+		}
+
+		DecimaArchiveSet set;
+		set.gameDirectory = directory;
+		auto pack = std::make_unique<DecimaPack>();
+		pack->relativePath = packName;
+		pack->decompress = StoredDecompressChunk;
+		Utils::GetFileSizeAndWriteTime(directory + L"\\" + packName, pack->size, pack->lastWriteTime);
+		set.packs.push_back(std::move(pack));
+
+		std::string error;
+		auto start = std::chrono::steady_clock::now();
+		if (!BuildArchiveIndex(set, error))
+		{
+			Logging::Write(logPrefix, "Benchmark %u/%s: %s", fileCount, variant, error.c_str());
+			return;
+		}
+		const double buildMs = ElapsedMilliseconds(start);
+
+		DecimaArchiveSet warmSet;
+		warmSet.gameDirectory = directory;
+		auto warmPack = std::make_unique<DecimaPack>();
+		warmPack->relativePath = set.packs[0]->relativePath;
+		warmPack->size = set.packs[0]->size;
+		warmPack->lastWriteTime = set.packs[0]->lastWriteTime;
+		warmSet.packs.push_back(std::move(warmPack));
+		start = std::chrono::steady_clock::now();
+		const bool warmLoaded = LoadArchiveIndexFile(warmSet);
+		const double warmMs = ElapsedMilliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		if (!LoadPackChunks(set, *set.packs[0], error))
+		{
+			Logging::Write(logPrefix, "Benchmark %u/%s: %s", fileCount, variant, error.c_str());
+			return;
+		}
+		const double chunkTableMs = ElapsedMilliseconds(start);
+
+		std::vector<uint64_t> lookupHashes;
+		lookupHashes.reserve(benchmarkLookupCount);
+		for (size_t i = 0; i < benchmarkLookupCount; i++)
+		{
+			const uint32_t fileIndex = static_cast<uint32_t>(i * 7919u % fileCount);
+			lookupHashes.push_back(ComputeDecimaPathHash(BuildBenchmarkPath(fileIndex)));
+		}
+		size_t found = 0;
+		start = std::chrono::steady_clock::now();
+		for (uint64_t hash : lookupHashes)
+		{
+			DecimaArchiveSetEntry entry{};
+			found += FindArchiveSetEntry(set, hash, entry) ? 1u : 0u;
+		}
+		const double lookupNs = ElapsedMilliseconds(start) * 1e6 / benchmarkLookupCount;
+
+		std::vector<DecimaArchiveReader::ReadFileRequest> requests(benchmarkLargeFileCount);
+		std::vector<PackExtractTarget> targets(requests.size());
+		std::vector<PackChunkTask> tasks;
+		for (uint32_t i = 0; i < benchmarkLargeFileCount; i++)
+		{
+			requests[i].normalizedPath = BuildBenchmarkPath(i);
+			if (!PlanPackExtractTarget(set, requests[i], targets[i], tasks, error))
+			{
+				Logging::Write(logPrefix, "Benchmark %u/%s: %s", fileCount, variant, error.c_str());
+				return;
+			}
+			requests[i].output.assign(static_cast<size_t>(targets[i].end - targets[i].start), 0);
+			targets[i].output = requests[i].output.data();
+		}
+
+		DecimaChunkCache cache;
+		start = std::chrono::steady_clock::now();
+		ExtractPackChunks(cache, 0, tasks);
+		const double extractMs = ElapsedMilliseconds(start);
+
+		bool extracted = true;
+		size_t extractedBytes = 0;
+		for (size_t i = 0; i < targets.size(); i++)
+		{
+			const size_t copied = targets[i].copiedBytes.load();
+			extractedBytes += copied;
+			extracted = extracted
+				&& targets[i].status == PackChunkDecodeStatus::Success
+				&& copied == requests[i].output.size()
+				&& requests[i].output[0] == static_cast<uint8_t>(targets[i].start * 2654435761u >> 24);
+		}
+
+		Logging::Write(logPrefix,
+			"Benchmark %u entries/%s: index build %.2f ms, index reload %.2f ms%s, chunk table %.2f ms, "
+			"lookup %.1f ns (%zu/%zu found), extraction %.1f MB/s%s",
+			fileCount,
+			variant,
+			buildMs,
+			warmMs,
+			warmLoaded ? "" : " (rejected)",
+			chunkTableMs,
+			lookupNs,
+			found,
+			lookupHashes.size(),
+			extractMs > 0.0 ? extractedBytes / (extractMs * 1000.0) : 0.0,
+			extracted ? "" : " (output mismatch)"
+		);
+	}
+
+	// Caller must hold archiveSetMutex.
+	DecimaArchiveSet* GetArchiveSet(std::string& error)
+	{
+		if (archiveSet)
+		{
+			return archiveSet.get();
+		}
+
+		auto set = std::make_unique<DecimaArchiveSet>();
+		set->gameDirectory = Utils::GetCurrentModuleDirectory();
+		if (set->gameDirectory.empty())
+		{
+			error = "cannot resolve the game directory";
+			return nullptr;
+		}
+
+		set->packs = EnumeratePacks(set->gameDirectory);
+		if (set->packs.empty())
+		{
+			error = "no Decima archive was found";
+			return nullptr;
+		}
+
+		if (!LoadArchiveIndexFile(*set) && !BuildArchiveIndex(*set, error))
+		{
+			return nullptr;
+		}
+
+		archiveSet = std::move(set);
+		return archiveSet.get();
+	}
+}
+
+namespace DecimaArchiveReader
+{
+	std::string BuildStreamedWemPath(uint32_t sourceId)
+	{
+		const DecimaHash::StreamedWemPath path = DecimaHash::BuildStreamedWemPath(sourceId);
+		return std::string(path.chars.data(), path.length);
+	}
+
+	bool LoadArchiveIndex(std::string& error)
+	{
+		std::lock_guard<std::mutex> lock(archiveSetMutex);
+		return GetArchiveSet(error) != nullptr;
+	}
+
+	bool GetArchiveFileStamp(const std::string& normalizedPath, ArchiveFileStamp& stamp, std::string& error)
+	{
+		return GetArchiveFileStamp(ComputeDecimaPathHash(normalizedPath), stamp, error);
+	}
+
+	bool GetArchiveFileStamp(uint64_t pathHash, ArchiveFileStamp& stamp, std::string& error)
+	{
+		std::lock_guard<std::mutex> lock(archiveSetMutex);
+		const DecimaArchiveSet* set = GetArchiveSet(error);
+		if (!set)
+		{
+			return false;
+		}
+
+		DecimaArchiveSetEntry entry{};
+		if (!FindArchiveSetEntry(*set, pathHash, entry))
+		{
+			error = "could not find " + DescribeStream({}, pathHash);
+			return false;
+		}
+
+		const DecimaPack& pack = *set->packs[entry.pack];
+		stamp = { entry.size, pack.size, pack.lastWriteTime };
+		return true;
+	}
+
+	void ReadArchiveFiles(std::vector<ReadFileRequest>& requests)
+	{
+		std::vector<bool> pending(requests.size(), false);
+		bool anyPending = false;
+		for (size_t i = 0; i < requests.size(); i++)
+		{
+			ReadFileRequest& request = requests[i];
+			request.output.clear();
+			if (request.normalizedPath.empty() && request.pathHash == 0)
+			{
+				request.result = Fail(request.output, "Decima archive path is empty");
+			}
+			else if (
+				request.rangeLength == 0
+				&& (request.expectedSize < 16 || request.expectedSize > maxExtractedFileSize)
+			)
+			{
+				request.result = Fail(request.output, "expected Decima archive entry size is not valid");
+			}
+			else if (request.rangeLength > maxExtractedFileSize)
+			{
+				request.result = Fail(request.output, "requested Decima archive range is too large");
+			}
+			else
+			{
+				pending[i] = true;
+				anyPending = true;
+			}
+		}
+		if (!anyPending)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(archiveSetMutex);
+		std::string batchError;
+		DecimaArchiveSet* set = GetArchiveSet(batchError);
+		if (set && !ResolveOodleDecompress())
+		{
+			batchError = "Oodle decompressor oo2core_7_win64.dll is not available";
+		}
+		if (!set || !batchError.empty())
+		{
+			for (size_t i = 0; i < requests.size(); i++)
+			{
+				if (pending[i])
+				{
+					requests[i].result = Fail(requests[i].output, batchError);
+				}
+			}
+			return;
+		}
+
+		// Targets are sized once up front; tasks keep pointers into this vector.
+		std::vector<PackExtractTarget> targets(requests.size());
+		std::vector<PackChunkTask> chunkTasks;
+		for (size_t i = 0; i < requests.size(); i++)
+		{
+			if (!pending[i])
+			{
+				continue;
+			}
+
+			ReadFileRequest& request = requests[i];
+			std::string error;
+			const size_t firstTask = chunkTasks.size();
+			if (!PlanPackExtractTarget(
+				*set,
+				request,
+				targets[i],
+				chunkTasks,
+				error
+			))
+			{
+				chunkTasks.resize(firstTask);
+				request.result = Fail(request.output, error);
+				pending[i] = false;
+				continue;
+			}
+
+			request.output.assign(static_cast<size_t>(targets[i].end - targets[i].start), 0);
+			targets[i].output = request.output.data();
+		}
+
+		// Entries packed back to back share boundary chunks; each chunk is decoded once for all of them.
+		std::stable_sort(
+			chunkTasks.begin(),
+			chunkTasks.end(),
+			[](const PackChunkTask& lhs, const PackChunkTask& rhs)
+			{
+				return lhs.cacheKey < rhs.cacheKey;
+			}
+		);
+		std::vector<PackChunkTask> tasks;
+		for (PackChunkTask& chunkTask : chunkTasks)
+		{
+			if (!tasks.empty() && tasks.back().cacheKey == chunkTask.cacheKey)
+			{
+				tasks.back().targets.push_back(chunkTask.targets.front());
+				continue;
+			}
+			tasks.push_back(std::move(chunkTask));
+		}
+
+		ExtractPackChunks(archiveChunkCache, GetChunkCacheBudget(), tasks);
+
+		for (size_t i = 0; i < requests.size(); i++)
+		{
+			if (!pending[i])
+			{
+				continue;
+			}
+
+			ReadFileRequest& request = requests[i];
+			const PackExtractTarget& target = targets[i];
+			const size_t copiedBytes = target.copiedBytes.load();
+			if (target.status == PackChunkDecodeStatus::ReadFailed)
+			{
+				request.result = Fail(request.output, "failed to read Decima archive chunk", copiedBytes);
+			}
+			else if (target.status == PackChunkDecodeStatus::DecompressFailed)
+			{
+				request.result = Fail(request.output, "failed to decompress Decima archive chunk", copiedBytes);
+			}
+			else if (copiedBytes != request.output.size())
+			{
+				request.result = Fail(request.output,
+					"Decima archive extraction copied "
+					+ std::to_string(copiedBytes)
+					+ " of " + std::to_string(request.output.size())
+					+ " bytes",
+					copiedBytes
+				);
+			}
+			else
+			{
+				request.result = { true, {}, copiedBytes };
+			}
+		}
+	}
+
+	ChunkCacheStats GetChunkCacheStats()
+	{
+		return archiveChunkCache.GetStats(GetChunkCacheBudget());
+	}
+
+	ReadFileResult ReadArchiveFile(
+		const std::string& normalizedPath,
+		uint32_t expectedSize,
+		std::vector<uint8_t>& output
+	)
+	{
+		std::vector<ReadFileRequest> requests(1);
+		requests[0].normalizedPath = normalizedPath;
+		requests[0].expectedSize = expectedSize;
+		ReadArchiveFiles(requests);
+		output = std::move(requests[0].output);
+		return requests[0].result;
+	}
+
+	ReadFileResult ReadArchiveFile(uint64_t pathHash, uint32_t expectedSize, std::vector<uint8_t>& output)
+	{
+		std::vector<ReadFileRequest> requests(1);
+		requests[0].pathHash = pathHash;
+		requests[0].expectedSize = expectedSize;
+		ReadArchiveFiles(requests);
+		output = std::move(requests[0].output);
+		return requests[0].result;
+	}
+
+	ReadFileResult ReadArchiveFileRange(
+		const std::string& normalizedPath,
+		uint32_t offset,
+		uint32_t length,
+		std::vector<uint8_t>& output
+	)
+	{
+		if (length == 0)
+		{
+			return Fail(output, "requested Decima archive range is empty");
+		}
+
+		std::vector<ReadFileRequest> requests(1);
+		requests[0].normalizedPath = normalizedPath;
+		requests[0].rangeOffset = offset;
+		requests[0].rangeLength = length;
+		ReadArchiveFiles(requests);
+		output = std::move(requests[0].output);
+		return requests[0].result;
+	}
+
+	void LogBenchmarks()
+	{
+		wchar_t tempDirectory[MAX_PATH]{};
+		if (GetTempPathW(MAX_PATH, tempDirectory) == 0)
+		{
+			return;
+		}
+
+		const std::wstring directory = std::wstring(tempDirectory) + L"walkingman_benchmark";
+		if (!CreateDirectoryW(directory.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+		{
+			Logging::Write(logPrefix, "Benchmark: could not create %s", Utils::WstringToUtf8(directory).c_str());
+			return;
+		}
+
+		for (uint32_t fileCount : { 1000u, 10000u, 100000u, 1000000u })
+		{
+			RunPackBenchmark(directory, fileCount, false);
+			RunPackBenchmark(directory, fileCount, true);
 		}
 
-		return { true, {}, copiedBytes };
+		std::error_code ec;
+		std::filesystem::remove_all(directory, ec);
 	}
 }
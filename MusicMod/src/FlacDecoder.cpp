@@ -0,0 +1,626 @@
+#include "FlacDecoder.h"
+
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t maxChannels = 8;
+	constexpr uint32_t minBitsPerSample = 4;
+	// Keeps every intermediate value, including the extra bit of a side channel, inside 32 bits.
+	constexpr uint32_t maxBitsPerSample = 24;
+	constexpr uint32_t outputBitsPerSample = 16;
+	constexpr uint32_t maxLpcOrder = 32;
+
+	constexpr uint8_t metadataStreamInfo = 0;
+	constexpr size_t streamInfoSize = 34;
+
+	enum ChannelAssignment : uint32_t
+	{
+		leftSide = 8,
+		sideRight = 9,
+		midSide = 10
+	};
+
+	// FLAC fixes the speaker order for each channel count; these are the matching WAVE speaker masks.
+	constexpr uint32_t channelMasks[maxChannels] = { 0x4, 0x3, 0x7, 0x33, 0x37, 0x3f, 0x70f, 0x63f };
+
+	uint32_t CountLeadingZeros64(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanReverse64(&index, value);
+		return 63 - index;
+#else
+		return static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+	}
+
+	// Reads MSB-first through a 64-bit cache. Running off the end yields zeros and marks the reader as overrun
+	// instead of failing every call, so callers only have to check once per frame.
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t* bytes, size_t size, size_t offset)
+			: bytes_(bytes), size_(size), position_(offset)
+		{}
+
+		// count is at most 32.
+		uint32_t Read(uint32_t count)
+		{
+			if (count == 0)
+			{
+				return 0;
+			}
+			if (available_ < count)
+			{
+				Refill();
+				if (available_ < count)
+				{
+					overrun_ = true;
+					cache_ = 0;
+					available_ = 0;
+					return 0;
+				}
+			}
+
+			const uint32_t value = static_cast<uint32_t>(cache_ >> (64 - count));
+			cache_ <<= count;
+			available_ -= count;
+			return value;
+		}
+
+		int32_t ReadSigned(uint32_t count)
+		{
+			if (count == 0)
+			{
+				return 0;
+			}
+			const uint32_t signBit = 1u << (count - 1);
+			return static_cast<int32_t>((Read(count) ^ signBit) - signBit);
+		}
+
+		// Counts zero bits up to and including the next one bit.
+		uint32_t ReadUnary()
+		{
+			uint32_t zeros = 0;
+			while (cache_ == 0)
+			{
+				zeros += available_;
+				available_ = 0;
+				Refill();
+				if (available_ == 0)
+				{
+					overrun_ = true;
+					return 0;
+				}
+			}
+
+			// Bits below the cached ones are always zero, so the leading one is a cached bit.
+			const uint32_t leadingZeros = CountLeadingZeros64(cache_);
+			const uint32_t consumed = leadingZeros + 1;
+			cache_ = consumed < 64 ? cache_ << consumed : 0;
+			available_ -= consumed;
+			return zeros + leadingZeros;
+		}
+
+		void AlignToByte()
+		{
+			const uint32_t padding = available_ % 8;
+			cache_ <<= padding;
+			available_ -= padding;
+		}
+
+		// Only meaningful while byte aligned.
+		size_t BytePosition() const { return position_ - available_ / 8; }
+		bool Overrun() const { return overrun_; }
+
+	private:
+		void Refill()
+		{
+			while (available_ <= 56 && position_ < size_)
+			{
+				cache_ |= static_cast<uint64_t>(bytes_[position_++]) << (56 - available_);
+				available_ += 8;
+			}
+		}
+
+		const uint8_t* bytes_ = nullptr;
+		size_t size_ = 0;
+		size_t position_ = 0;
+		uint64_t cache_ = 0;
+		uint32_t available_ = 0;
+		bool overrun_ = false;
+	};
+
+	uint32_t ReadBe24(const uint8_t* bytes)
+	{
+		return (static_cast<uint32_t>(bytes[0]) << 16) | (static_cast<uint32_t>(bytes[1]) << 8) | bytes[2];
+	}
+
+	// Some taggers put an ID3v2 block in front of the stream marker.
+	size_t SkipId3v2(const uint8_t* bytes, size_t size)
+	{
+		if (size < 10 || std::memcmp(bytes, "ID3", 3) != 0)
+		{
+			return 0;
+		}
+
+		const size_t tagSize = (static_cast<size_t>(bytes[6] & 0x7f) << 21)
+			| (static_cast<size_t>(bytes[7] & 0x7f) << 14)
+			| (static_cast<size_t>(bytes[8] & 0x7f) << 7)
+			| static_cast<size_t>(bytes[9] & 0x7f);
+		const bool hasFooter = (bytes[5] & 0x10) != 0;
+		return 10 + tagSize + (hasFooter ? 10 : 0);
+	}
+
+	// Returns the offset of the first frame.
+	bool ReadMetadata(const uint8_t* bytes, size_t size, FlacDecoder::StreamInfo& info, size_t& frameOffset)
+	{
+		size_t offset = SkipId3v2(bytes, size);
+		if (offset > size || size - offset < 4 || std::memcmp(bytes + offset, "fLaC", 4) != 0)
+		{
+			return false;
+		}
+		offset += 4;
+
+		bool hasStreamInfo = false;
+		bool isLast = false;
+		while (!isLast)
+		{
+			if (size - offset < 4)
+			{
+				return false;
+			}
+			isLast = (bytes[offset] & 0x80) != 0;
+			const uint8_t type = bytes[offset] & 0x7f;
+			const uint32_t length = ReadBe24(bytes + offset + 1);
+			offset += 4;
+			if (length > size - offset)
+			{
+				return false;
+			}
+
+			if (type == metadataStreamInfo && length >= streamInfoSize)
+			{
+				BitReader reader(bytes, offset + streamInfoSize, offset);
+				reader.Read(16);
+				reader.Read(16);
+				reader.Read(24);
+				reader.Read(24);
+				info.sampleRate = reader.Read(20);
+				info.channels = reader.Read(3) + 1;
+				info.bitsPerSample = reader.Read(5) + 1;
+				info.totalSamples = (static_cast<uint64_t>(reader.Read(4)) << 32) | reader.Read(32);
+				hasStreamInfo = true;
+			}
+			offset += length;
+		}
+
+		frameOffset = offset;
+		return hasStreamInfo
+			&& info.sampleRate != 0
+			&& info.bitsPerSample >= minBitsPerSample
+			&& info.bitsPerSample <= maxBitsPerSample;
+	}
+
+	bool SkipUtf8CodedNumber(BitReader& reader)
+	{
+		const uint32_t first = reader.Read(8);
+		uint32_t extraBytes = 0;
+		for (uint32_t mask = 0x80; (first & mask) != 0 && mask != 0; mask >>= 1)
+		{
+			extraBytes++;
+		}
+		if (extraBytes == 1 || extraBytes > 7)
+		{
+			return false;
+		}
+
+		for (uint32_t i = 1; i < extraBytes; i++)
+		{
+			if ((reader.Read(8) & 0xc0) != 0x80)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Rice partitions store zigzag-folded residuals after the warm-up samples, which the prediction then
+	// turns into samples in place.
+	bool ReadResidual(BitReader& reader, uint32_t blockSize, uint32_t order, int32_t* samples)
+	{
+		const uint32_t method = reader.Read(2);
+		if (method > 1)
+		{
+			return false;
+		}
+		const uint32_t parameterBits = method == 0 ? 4 : 5;
+		const uint32_t escapeParameter = (1u << parameterBits) - 1;
+
+		const uint32_t partitionOrder = reader.Read(4);
+		const uint32_t partitionSize = blockSize >> partitionOrder;
+		if ((partitionSize << partitionOrder) != blockSize || partitionSize < order)
+		{
+			return false;
+		}
+
+		uint32_t sample = order;
+		for (uint32_t partition = 0; partition < (1u << partitionOrder); partition++)
+		{
+			const uint32_t partitionEnd = (partition + 1) * partitionSize;
+			const uint32_t parameter = reader.Read(parameterBits);
+			if (parameter == escapeParameter)
+			{
+				const uint32_t rawBits = reader.Read(5);
+				for (; sample < partitionEnd; sample++)
+				{
+					samples[sample] = reader.ReadSigned(rawBits);
+				}
+				continue;
+			}
+
+			for (; sample < partitionEnd; sample++)
+			{
+				const uint32_t quotient = reader.ReadUnary();
+				const uint32_t folded = (quotient << parameter) | reader.Read(parameter);
+				samples[sample] = static_cast<int32_t>((folded >> 1) ^ (0u - (folded & 1)));
+			}
+		}
+		return !reader.Overrun();
+	}
+
+	void RestoreFixed(uint32_t blockSize, uint32_t order, int32_t* samples)
+	{
+		for (uint32_t i = order; i < blockSize; i++)
+		{
+			int64_t prediction = 0;
+			switch (order)
+			{
+				case 1:
+					prediction = samples[i - 1];
+					break;
+				case 2:
+					prediction = 2ll * samples[i - 1] - samples[i - 2];
+					break;
+				case 3:
+					prediction = 3ll * samples[i - 1] - 3ll * samples[i - 2] + samples[i - 3];
+					break;
+				case 4:
+					prediction = 4ll * samples[i - 1] - 6ll * samples[i - 2] + 4ll * samples[i - 3] - samples[i - 4];
+					break;
+				default:
+					break;
+			}
+			samples[i] = static_cast<int32_t>(samples[i] + prediction);
+		}
+	}
+
+	void RestoreLpc(
+		uint32_t blockSize,
+		uint32_t order,
+		const int32_t* coefficients,
+		uint32_t shift,
+		int32_t* samples
+	)
+	{
+		for (uint32_t i = order; i < blockSize; i++)
+		{
+			int64_t sum = 0;
+			for (uint32_t j = 0; j < order; j++)
+			{
+				sum += static_cast<int64_t>(coefficients[j]) * samples[i - 1 - j];
+			}
+			samples[i] = static_cast<int32_t>(samples[i] + (sum >> shift));
+		}
+	}
+
+	bool ReadSubframe(BitReader& reader, uint32_t blockSize, uint32_t bitsPerSample, int32_t* samples)
+	{
+		if (reader.Read(1) != 0)
+		{
+			return false;
+		}
+		const uint32_t type = reader.Read(6);
+		uint32_t wastedBits = 0;
+		if (reader.Read(1) != 0)
+		{
+			wastedBits = reader.ReadUnary() + 1;
+			if (wastedBits >= bitsPerSample)
+			{
+				return false;
+			}
+			bitsPerSample -= wastedBits;
+		}
+
+		if (type == 0)
+		{
+			const int32_t value = reader.ReadSigned(bitsPerSample);
+			for (uint32_t i = 0; i < blockSize; i++)
+			{
+				samples[i] = value;
+			}
+		}
+		else if (type == 1)
+		{
+			for (uint32_t i = 0; i < blockSize; i++)
+			{
+				samples[i] = reader.ReadSigned(bitsPerSample);
+			}
+		}
+		else if (type >= 8 && type <= 12)
+		{
+			const uint32_t order = type - 8;
+			if (order > blockSize)
+			{
+				return false;
+			}
+			for (uint32_t i = 0; i < order; i++)
+			{
+				samples[i] = reader.ReadSigned(bitsPerSample);
+			}
+			if (!ReadResidual(reader, blockSize, order, samples))
+			{
+				return false;
+			}
+			RestoreFixed(blockSize, order, samples);
+		}
+		else if (type >= 32)
+		{
+			const uint32_t order = type - 31;
+			if (order > blockSize)
+			{
+				return false;
+			}
+			for (uint32_t i = 0; i < order; i++)
+			{
+				samples[i] = reader.ReadSigned(bitsPerSample);
+			}
+
+			const uint32_t precision = reader.Read(4) + 1;
+			const int32_t shift = reader.ReadSigned(5);
+			if (precision == 16 || shift < 0)
+			{
+				return false;
+			}
+			int32_t coefficients[maxLpcOrder]{};
+			for (uint32_t i = 0; i < order; i++)
+			{
+				coefficients[i] = reader.ReadSigned(precision);
+			}
+			if (!ReadResidual(reader, blockSize, order, samples))
+			{
+				return false;
+			}
+			RestoreLpc(blockSize, order, coefficients, static_cast<uint32_t>(shift), samples);
+		}
+		else
+		{
+			return false;
+		}
+
+		if (wastedBits != 0)
+		{
+			for (uint32_t i = 0; i < blockSize; i++)
+			{
+				samples[i] = static_cast<int32_t>(static_cast<uint32_t>(samples[i]) << wastedBits);
+			}
+		}
+		return !reader.Overrun();
+	}
+
+	// Decodes the frame at reader's position into channel-major samples and leaves the reader after its CRC.
+	bool ReadFrame(
+		BitReader& reader,
+		const FlacDecoder::StreamInfo& info,
+		std::vector<int32_t>& samples,
+		uint32_t& blockSize
+	)
+	{
+		if (reader.Read(15) != 0x7ffc)
+		{
+			return false;
+		}
+		reader.Read(1);
+
+		const uint32_t blockSizeCode = reader.Read(4);
+		const uint32_t sampleRateCode = reader.Read(4);
+		const uint32_t assignment = reader.Read(4);
+		const uint32_t sampleSizeCode = reader.Read(3);
+		if (reader.Read(1) != 0 || !SkipUtf8CodedNumber(reader))
+		{
+			return false;
+		}
+
+		if (blockSizeCode == 0)
+		{
+			return false;
+		}
+		else if (blockSizeCode == 1)
+		{
+			blockSize = 192;
+		}
+		else if (blockSizeCode <= 5)
+		{
+			blockSize = 576u << (blockSizeCode - 2);
+		}
+		else if (blockSizeCode == 6)
+		{
+			blockSize = reader.Read(8) + 1;
+		}
+		else if (blockSizeCode == 7)
+		{
+			blockSize = reader.Read(16) + 1;
+		}
+		else
+		{
+			blockSize = 256u << (blockSizeCode - 8);
+		}
+
+		// The frame's own rate only matters for streams without STREAMINFO, which are rejected earlier.
+		if (sampleRateCode == 12)
+		{
+			reader.Read(8);
+		}
+		else if (sampleRateCode == 13 || sampleRateCode == 14)
+		{
+			reader.Read(16);
+		}
+		else if (sampleRateCode == 15)
+		{
+			return false;
+		}
+
+		static constexpr uint32_t sampleSizes[8] = { 0, 8, 12, 0, 16, 20, 24, 32 };
+		const uint32_t bitsPerSample = sampleSizeCode == 0 ? info.bitsPerSample : sampleSizes[sampleSizeCode];
+		const uint32_t channels = assignment < leftSide ? assignment + 1 : 2;
+		if (
+			bitsPerSample != info.bitsPerSample
+			|| assignment > midSide
+			|| channels != info.channels
+		)
+		{
+			return false;
+		}
+		reader.Read(8);
+
+		samples.resize(static_cast<size_t>(blockSize) * channels);
+		for (uint32_t channel = 0; channel < channels; channel++)
+		{
+			const bool isSide = (assignment == leftSide && channel == 1)
+				|| (assignment == sideRight && channel == 0)
+				|| (assignment == midSide && channel == 1);
+			int32_t* channelSamples = samples.data() + static_cast<size_t>(channel) * blockSize;
+			if (!ReadSubframe(reader, blockSize, bitsPerSample + (isSide ? 1 : 0), channelSamples))
+			{
+				return false;
+			}
+		}
+
+		reader.AlignToByte();
+		reader.Read(16);
+		if (reader.Overrun())
+		{
+			return false;
+		}
+
+		// Corrupt frames can hold anything, so the arithmetic wraps instead of overflowing.
+		int32_t* first = samples.data();
+		int32_t* second = samples.data() + blockSize;
+		if (assignment == leftSide)
+		{
+			for (uint32_t i = 0; i < blockSize; i++)
+			{
+				second[i] = static_cast<int32_t>(static_cast<uint32_t>(first[i]) - static_cast<uint32_t>(second[i]));
+			}
+		}
+		else if (assignment == sideRight)
+		{
+			for (uint32_t i = 0; i < blockSize; i++)
+			{
+				first[i] = static_cast<int32_t>(static_cast<uint32_t>(first[i]) + static_cast<uint32_t>(second[i]));
+			}
+		}
+		else if (assignment == midSide)
+		{
+			for (uint32_t i = 0; i < blockSize; i++)
+			{
+				const uint32_t side = static_cast<uint32_t>(second[i]);
+				const uint32_t mid = (static_cast<uint32_t>(first[i]) << 1) | (side & 1);
+				first[i] = static_cast<int32_t>(mid + side) >> 1;
+				second[i] = static_cast<int32_t>(mid - side) >> 1;
+			}
+		}
+		return true;
+	}
+
+	void AppendInterleaved16(
+		const std::vector<int32_t>& samples,
+		uint32_t blockSize,
+		uint32_t channels,
+		uint32_t bitsPerSample,
+		uint8_t* target
+	)
+	{
+		for (uint32_t i = 0; i < blockSize; i++)
+		{
+			for (uint32_t channel = 0; channel < channels; channel++)
+			{
+				int32_t value = samples[static_cast<size_t>(channel) * blockSize + i];
+				value = bitsPerSample >= outputBitsPerSample
+					? value >> (bitsPerSample - outputBitsPerSample)
+					: static_cast<int32_t>(static_cast<uint32_t>(value) << (outputBitsPerSample - bitsPerSample));
+				const uint16_t sample = static_cast<uint16_t>(value);
+				target[0] = static_cast<uint8_t>(sample);
+				target[1] = static_cast<uint8_t>(sample >> 8);
+				target += 2;
+			}
+		}
+	}
+}
+
+bool FlacDecoder::Decode(
+	const uint8_t* bytes,
+	size_t size,
+	std::vector<uint8_t>& pcm,
+	StreamInfo& info,
+	size_t maxPcmBytes,
+	const std::atomic<bool>* canceled
+)
+{
+	info = {};
+	size_t offset = 0;
+	if (!bytes || !ReadMetadata(bytes, size, info, offset) || info.channels > maxChannels)
+	{
+		return false;
+	}
+	info.channelMask = channelMasks[info.channels - 1];
+
+	const size_t startSize = pcm.size();
+	const size_t bytesPerFrame = static_cast<size_t>(info.channels) * (outputBitsPerSample / 8);
+	if (info.totalSamples != 0)
+	{
+		const uint64_t expectedBytes = info.totalSamples * bytesPerFrame;
+		pcm.reserve(startSize + static_cast<size_t>(expectedBytes < maxPcmBytes ? expectedBytes : maxPcmBytes));
+	}
+
+	std::vector<int32_t> samples;
+	uint64_t decodedSamples = 0;
+	// Trailing tags or padding after the last frame end the stream like the end of the file does.
+	while (
+		size - offset >= 2
+		&& bytes[offset] == 0xff
+		&& (bytes[offset + 1] & 0xfe) == 0xf8
+		&& (info.totalSamples == 0 || decodedSamples < info.totalSamples)
+	)
+	{
+		if (canceled && canceled->load())
+		{
+			return false;
+		}
+
+		BitReader reader(bytes, size, offset);
+		uint32_t blockSize = 0;
+		if (!ReadFrame(reader, info, samples, blockSize))
+		{
+			return false;
+		}
+		offset = reader.BytePosition();
+
+		const size_t frameBytes = static_cast<size_t>(blockSize) * bytesPerFrame;
+		if (frameBytes > maxPcmBytes - (pcm.size() - startSize))
+		{
+			return false;
+		}
+		const size_t writeOffset = pcm.size();
+		pcm.resize(writeOffset + frameBytes);
+		AppendInterleaved16(samples, blockSize, info.channels, info.bitsPerSample, pcm.data() + writeOffset);
+		decodedSamples += blockSize;
+	}
+
+	return decodedSamples != 0;
+}
@@ -0,0 +1,140 @@
+#include "ImaAdpcmEncoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	constexpr int32_t maxStepIndex = 88;
+
+	constexpr int32_t stepSizes[maxStepIndex + 1] = {
+		7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+		19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+		50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+		130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+		337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+		876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+		2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+		5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+		15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+	};
+
+	constexpr int32_t stepIndexAdjustments[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+	struct ChannelState
+	{
+		int32_t predictor = 0;
+		int32_t stepIndex = 0;
+	};
+
+	// Picks the nibble the decoder will expand closest to sample, then follows the decoder's own arithmetic so
+	// both sides keep the same predictor.
+	uint8_t EncodeSample(ChannelState& state, int32_t sample)
+	{
+		const int32_t step = stepSizes[state.stepIndex];
+		int32_t difference = sample - state.predictor;
+		uint8_t nibble = 0;
+		if (difference < 0)
+		{
+			nibble = 8;
+			difference = -difference;
+		}
+
+		int32_t delta = step >> 3;
+		if (difference >= step)
+		{
+			nibble |= 4;
+			difference -= step;
+			delta += step;
+		}
+		if (difference >= (step >> 1))
+		{
+			nibble |= 2;
+			difference -= step >> 1;
+			delta += step >> 1;
+		}
+		if (difference >= (step >> 2))
+		{
+			nibble |= 1;
+			delta += step >> 2;
+		}
+
+		state.predictor = std::clamp(state.predictor + ((nibble & 8) != 0 ? -delta : delta), -32768, 32767);
+		state.stepIndex = std::clamp(state.stepIndex + stepIndexAdjustments[nibble & 7], 0, maxStepIndex);
+		return nibble;
+	}
+
+	// Starts a new stream where its first two samples suggest, instead of climbing up from the smallest step.
+	int32_t GetInitialStepIndex(int32_t first, int32_t second)
+	{
+		const int32_t difference = std::abs(second - first);
+		int32_t stepIndex = 0;
+		while (stepIndex < maxStepIndex && stepSizes[stepIndex] < difference)
+		{
+			stepIndex++;
+		}
+		return stepIndex;
+	}
+}
+
+size_t ImaAdpcmEncoder::GetBlockCount(size_t frameCount)
+{
+	return (frameCount + samplesPerBlock - 1) / samplesPerBlock;
+}
+
+size_t ImaAdpcmEncoder::GetEncodedSize(size_t frameCount, uint32_t channels)
+{
+	return GetBlockCount(frameCount) * bytesPerChannelBlock * channels;
+}
+
+bool ImaAdpcmEncoder::Encode(const uint8_t* pcm, size_t frameCount, uint32_t channels, uint8_t* target)
+{
+	if (!pcm || !target || frameCount == 0 || channels == 0 || channels > maxChannels)
+	{
+		return false;
+	}
+
+	ChannelState states[maxChannels]{};
+	int16_t blockSamples[samplesPerBlock * maxChannels]{};
+	const size_t frameSize = static_cast<size_t>(channels) * sizeof(int16_t);
+	const size_t blockCount = GetBlockCount(frameCount);
+	for (size_t block = 0; block < blockCount; block++)
+	{
+		// The whole block is read before any of it is written, which is what makes encoding in place safe.
+		const size_t firstFrame = block * samplesPerBlock;
+		const size_t blockFrames = (std::min)(static_cast<size_t>(samplesPerBlock), frameCount - firstFrame);
+		std::memcpy(blockSamples, pcm + firstFrame * frameSize, blockFrames * frameSize);
+		for (size_t frame = blockFrames; frame < samplesPerBlock; frame++)
+		{
+			std::memcpy(blockSamples + frame * channels, blockSamples + (blockFrames - 1) * channels, frameSize);
+		}
+
+		uint8_t* blockTarget = target + block * bytesPerChannelBlock * channels;
+		for (uint32_t channel = 0; channel < channels; channel++)
+		{
+			ChannelState& state = states[channel];
+			const int16_t first = blockSamples[channel];
+			if (block == 0)
+			{
+				state.stepIndex = GetInitialStepIndex(first, blockSamples[channels + channel]);
+			}
+			state.predictor = first;
+
+			uint8_t* header = blockTarget + channel * 4;
+			header[0] = static_cast<uint8_t>(static_cast<uint16_t>(first));
+			header[1] = static_cast<uint8_t>(static_cast<uint16_t>(first) >> 8);
+			header[2] = static_cast<uint8_t>(state.stepIndex);
+			header[3] = 0;
+
+			uint8_t* data = blockTarget + channels * 4 + channel * (bytesPerChannelBlock - 4);
+			for (uint32_t sample = 1; sample < samplesPerBlock; sample += 2)
+			{
+				const uint8_t low = EncodeSample(state, blockSamples[sample * channels + channel]);
+				const uint8_t high = EncodeSample(state, blockSamples[(sample + 1) * channels + channel]);
+				*data++ = static_cast<uint8_t>(low | (high << 4));
+			}
+		}
+	}
+	return true;
+}
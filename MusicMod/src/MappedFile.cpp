@@ -0,0 +1,117 @@
+#include "MappedFile.h"
+
+#include <cstring>
+
+namespace
+{
+	bool CopyMappedBytesNoUnwind(void* target, const void* source, size_t size)
+	{
+		__try
+		{
+			std::memcpy(target, source, size);
+			return true;
+		}
+		__except (EXCEPTION_EXECUTE_HANDLER)
+		{
+			return false;
+		}
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::wstring& path, bool copyOnWrite)
+{
+	Close();
+
+	file_ = CreateFileW(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr
+	);
+	if (file_ == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	mapping_ = CreateFileMappingW(file_, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_)
+	{
+		Close();
+		return false;
+	}
+
+	data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+	if (!data_)
+	{
+		Close();
+		return false;
+	}
+
+	size_ = static_cast<uint64_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+		data_ = nullptr;
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+		mapping_ = nullptr;
+	}
+	if (file_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+	size_ = 0;
+}
+
+bool MappedFile::Read(uint64_t offset, void* bytes, size_t size) const
+{
+	if ((!bytes && size != 0) || !Contains(offset, size))
+	{
+		return false;
+	}
+
+	return CopyMappedBytesNoUnwind(bytes, data_ + offset, size);
+}
+
+bool MappedFile::Contains(uint64_t offset, uint64_t size) const
+{
+	return data_
+		&& offset <= size_
+		&& size <= size_ - offset;
+}
+
+void MappedFile::Prefetch(uint64_t offset, uint64_t size) const
+{
+	if (size == 0 || !Contains(offset, size))
+	{
+		return;
+	}
+
+	WIN32_MEMORY_RANGE_ENTRY range{};
+	range.VirtualAddress = const_cast<uint8_t*>(data_ + offset);
+	range.NumberOfBytes = static_cast<SIZE_T>(size);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
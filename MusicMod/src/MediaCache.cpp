@@ -0,0 +1,436 @@
+#include "MediaCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <Windows.h>
+
+#include "DecimaHash.h"
+#include "MappedFile.h"
+#include "ModConfiguration.h"
+#include "Utils.h"
+
+namespace
+{
+	constexpr const wchar_t* cacheDirectoryName = L"walkingman_cache";
+	constexpr uint32_t internalMediaMagic = 0x4d43574d; // "MWCM"
+	constexpr uint32_t internalMediaVersion = 1;
+	constexpr size_t internalMediaHeaderSize = 40;
+	constexpr const wchar_t* transcodeDirectoryName = L"transcoded";
+	constexpr uint32_t transcodedMediaMagic = 0x5443574d; // "MWCT"
+	constexpr uint32_t transcodedMediaVersion = 1;
+	constexpr size_t transcodedMediaHeaderSize = 64;
+	// Keeps the media at least as aligned in the mapped view as it would be in a heap buffer.
+	constexpr size_t transcodedMediaAlignment = 16;
+	constexpr uint32_t transcodedMediaDecodedToPcmFlag = 1;
+
+	// Header layout (little endian):
+	//   u32 magic, u32 version, u32 source id, u32 media size,
+	//   u64 pack size, u64 pack last write time, u64 checksum of the media bytes
+
+	// Transcoded entry layout (little endian):
+	//   u32 magic, u32 version, u64 source size, u64 source last write time, i64 duration ms,
+	//   u32 source plugin id, u32 sample rate, u32 channels, u32 bits per sample,
+	//   u32 media size, u32 source path length, u32 flags, u32 reserved,
+	//   source path (UTF-8), zero padding up to the media alignment, media bytes
+	// Entries are written through a temp file and renamed, so a size check is enough to reject a damaged one
+	// without reading the whole media on every hit.
+
+	// Transcoded entries LoadTranscodedMedia has handed out. Windows will neither delete nor replace a file while a
+	// view of it exists, so eviction and stores leave these alone until the last buffer mapping them is released.
+	std::mutex mappedEntriesMutex;
+	std::unordered_map<std::wstring, std::weak_ptr<MappedFile>> mappedEntries;
+
+	void TrackMappedEntry(const std::wstring& path, const std::shared_ptr<MappedFile>& file)
+	{
+		std::lock_guard<std::mutex> lock(mappedEntriesMutex);
+		for (auto it = mappedEntries.begin(); it != mappedEntries.end();)
+		{
+			it = it->second.expired() ? mappedEntries.erase(it) : std::next(it);
+		}
+		mappedEntries[path] = file;
+	}
+
+	bool IsEntryMapped(const std::wstring& path)
+	{
+		std::lock_guard<std::mutex> lock(mappedEntriesMutex);
+		const auto it = mappedEntries.find(path);
+		return it != mappedEntries.end() && !it->second.expired();
+	}
+
+	// Word-at-a-time mix; only meant to catch truncated or damaged files, not tampering.
+	uint64_t ComputeChecksum(const uint8_t* bytes, size_t size)
+	{
+		uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			hash ^= Utils::ReadLe64(bytes + i);
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 32;
+		}
+		for (; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	std::wstring GetCacheDirectory()
+	{
+		const std::wstring moduleDirectory = Utils::GetCurrentModuleDirectory();
+		return moduleDirectory.empty() ? std::wstring{} : moduleDirectory + L"\\" + cacheDirectoryName;
+	}
+
+	std::wstring GetInternalMediaPath(uint32_t sourceId)
+	{
+		const std::wstring directory = GetCacheDirectory();
+		return directory.empty() ? std::wstring{} : directory + L"\\" + std::to_wstring(sourceId) + L".wem";
+	}
+
+	uint64_t GetTranscodeCacheBudget()
+	{
+		return static_cast<uint64_t>(ModConfiguration::transcodeCacheSizeMB) * 1024u * 1024u;
+	}
+
+	std::wstring GetTranscodeDirectory()
+	{
+		const std::wstring directory = GetCacheDirectory();
+		return directory.empty() ? std::wstring{} : directory + L"\\" + transcodeDirectoryName;
+	}
+
+	// Windows paths are case-insensitive, so entries are keyed by the absolute path folded to lower case.
+	std::string GetTranscodeKeyPath(const std::string& sourcePath)
+	{
+		std::error_code ec;
+		std::wstring absolutePath = std::filesystem::absolute(Utils::ToWidePath(sourcePath), ec).wstring();
+		if (ec || absolutePath.empty())
+		{
+			return {};
+		}
+		std::transform(
+			absolutePath.begin(),
+			absolutePath.end(),
+			absolutePath.begin(),
+			[](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); }
+		);
+		return Utils::WstringToUtf8(absolutePath);
+	}
+
+	std::wstring GetTranscodedMediaPath(const std::string& keyPath)
+	{
+		const std::wstring directory = GetTranscodeDirectory();
+		if (directory.empty() || keyPath.empty())
+		{
+			return {};
+		}
+
+		constexpr const wchar_t* hexDigits = L"0123456789abcdef";
+		const uint64_t hash = DecimaHash::ComputePathHash(keyPath.c_str(), keyPath.size());
+		std::wstring name(16, L'0');
+		for (size_t i = 0; i < name.size(); i++)
+		{
+			name[name.size() - 1 - i] = hexDigits[(hash >> (i * 4)) & 0xf];
+		}
+		return directory + L"\\" + name + L".wem";
+	}
+
+	size_t GetTranscodedMediaOffset(size_t keyPathLength)
+	{
+		const size_t unaligned = transcodedMediaHeaderSize + keyPathLength;
+		return (unaligned + transcodedMediaAlignment - 1) / transcodedMediaAlignment * transcodedMediaAlignment;
+	}
+
+	bool CreateDirectoryIfMissing(const std::wstring& directory)
+	{
+		return CreateDirectoryW(directory.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+
+	// Eviction goes by last write time, so a hit refreshes it.
+	void MarkRecentlyUsed(const std::wstring& path)
+	{
+		HANDLE file = CreateFileW(
+			path.c_str(),
+			FILE_WRITE_ATTRIBUTES,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr
+		);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		FILETIME now{};
+		GetSystemTimeAsFileTime(&now);
+		SetFileTime(file, nullptr, nullptr, &now);
+		CloseHandle(file);
+	}
+
+	// Removes the least recently used entries until incomingBytes more fit in the budget. Entries that are still
+	// mapped cannot be deleted, so they stay counted against the budget and the next oldest goes instead.
+	void EvictTranscodedMedia(const std::wstring& directory, const std::wstring& replacedPath, uint64_t incomingBytes)
+	{
+		struct CachedEntry
+		{
+			uint64_t lastWriteTime = 0;
+			uint64_t size = 0;
+			std::wstring path{};
+		};
+
+		std::vector<CachedEntry> entries;
+		uint64_t cachedBytes = 0;
+		WIN32_FIND_DATAW findData{};
+		HANDLE find = FindFirstFileW((directory + L"\\*.wem").c_str(), &findData);
+		if (find != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				CachedEntry entry{};
+				entry.path = directory + L"\\" + findData.cFileName;
+				if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 || entry.path == replacedPath)
+				{
+					continue;
+				}
+				entry.lastWriteTime = (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32)
+					| findData.ftLastWriteTime.dwLowDateTime;
+				entry.size = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+				cachedBytes += entry.size;
+				entries.push_back(std::move(entry));
+			} while (FindNextFileW(find, &findData));
+			FindClose(find);
+		}
+
+		std::sort(
+			entries.begin(),
+			entries.end(),
+			[](const CachedEntry& lhs, const CachedEntry& rhs) { return lhs.lastWriteTime < rhs.lastWriteTime; }
+		);
+		const uint64_t budget = GetTranscodeCacheBudget();
+		for (const CachedEntry& entry : entries)
+		{
+			if (cachedBytes + incomingBytes <= budget)
+			{
+				break;
+			}
+			if (!IsEntryMapped(entry.path) && DeleteFileW(entry.path.c_str()))
+			{
+				cachedBytes -= entry.size;
+			}
+		}
+	}
+
+	// Same temp-file-and-rename scheme as Utils::WriteFileBytesWide, without first joining header and media into
+	// one more copy of the track.
+	bool WriteTranscodedMediaFile(
+		const std::wstring& path,
+		const std::vector<uint8_t>& header,
+		const uint8_t* media,
+		size_t mediaSize
+	)
+	{
+		const std::wstring tempPath = path + L".tmp";
+		HANDLE file = CreateFileW(
+			tempPath.c_str(),
+			GENERIC_WRITE,
+			0,
+			nullptr,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr
+		);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		DWORD headerWritten = 0;
+		DWORD mediaWritten = 0;
+		const BOOL ok = WriteFile(file, header.data(), static_cast<DWORD>(header.size()), &headerWritten, nullptr)
+			&& WriteFile(file, media, static_cast<DWORD>(mediaSize), &mediaWritten, nullptr);
+		CloseHandle(file);
+		if (
+			!ok
+			|| headerWritten != header.size()
+			|| mediaWritten != mediaSize
+			|| !MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)
+		)
+		{
+			DeleteFileW(tempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
+
+bool MediaCache::LoadInternalMedia(const InternalMediaKey& key, std::vector<uint8_t>& bytes)
+{
+	bytes.clear();
+	const std::wstring path = GetInternalMediaPath(key.sourceId);
+	std::vector<uint8_t> fileBytes;
+	if (
+		path.empty()
+		|| !Utils::ReadFileBytesWide(path, fileBytes, internalMediaHeaderSize + static_cast<size_t>(key.mediaSize))
+		|| fileBytes.size() != internalMediaHeaderSize + key.mediaSize
+	)
+	{
+		return false;
+	}
+
+	const uint8_t* header = fileBytes.data();
+	const uint8_t* media = header + internalMediaHeaderSize;
+	if (
+		Utils::ReadLe32(header) != internalMediaMagic
+		|| Utils::ReadLe32(header + 4) != internalMediaVersion
+		|| Utils::ReadLe32(header + 8) != key.sourceId
+		|| Utils::ReadLe32(header + 12) != key.mediaSize
+		|| Utils::ReadLe64(header + 16) != key.packSize
+		|| Utils::ReadLe64(header + 24) != key.packLastWriteTime
+		|| Utils::ReadLe64(header + 32) != ComputeChecksum(media, key.mediaSize)
+	)
+	{
+		return false;
+	}
+
+	fileBytes.erase(fileBytes.begin(), fileBytes.begin() + internalMediaHeaderSize);
+	bytes = std::move(fileBytes);
+	return true;
+}
+
+bool MediaCache::StoreInternalMedia(const InternalMediaKey& key, const std::vector<uint8_t>& bytes)
+{
+	const std::wstring directory = GetCacheDirectory();
+	if (directory.empty() || bytes.size() != key.mediaSize)
+	{
+		return false;
+	}
+	if (!CreateDirectoryW(directory.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> fileBytes;
+	fileBytes.reserve(internalMediaHeaderSize + bytes.size());
+	Utils::AppendLe32(fileBytes, internalMediaMagic);
+	Utils::AppendLe32(fileBytes, internalMediaVersion);
+	Utils::AppendLe32(fileBytes, key.sourceId);
+	Utils::AppendLe32(fileBytes, key.mediaSize);
+	Utils::AppendLe64(fileBytes, key.packSize);
+	Utils::AppendLe64(fileBytes, key.packLastWriteTime);
+	Utils::AppendLe64(fileBytes, ComputeChecksum(bytes.data(), bytes.size()));
+	fileBytes.insert(fileBytes.end(), bytes.begin(), bytes.end());
+	return Utils::WriteFileBytesWide(GetInternalMediaPath(key.sourceId), fileBytes);
+}
+
+bool MediaCache::LoadTranscodedMedia(const std::string& sourcePath, AudioDecoder::WwiseMediaBuffer& media)
+{
+	if (GetTranscodeCacheBudget() == 0)
+	{
+		return false;
+	}
+
+	const std::string keyPath = GetTranscodeKeyPath(sourcePath);
+	const std::wstring path = GetTranscodedMediaPath(keyPath);
+	uint64_t sourceSize = 0;
+	uint64_t sourceLastWriteTime = 0;
+	if (path.empty() || !Utils::GetFileSizeAndWriteTime(Utils::ToWidePath(sourcePath), sourceSize, sourceLastWriteTime))
+	{
+		return false;
+	}
+
+	auto file = std::make_shared<MappedFile>();
+	uint8_t header[transcodedMediaHeaderSize]{};
+	if (!file->Open(path, true) || !file->Read(0, header, sizeof(header)))
+	{
+		return false;
+	}
+
+	const uint32_t mediaSize = Utils::ReadLe32(header + 48);
+	const uint32_t keyPathLength = Utils::ReadLe32(header + 52);
+	const size_t mediaOffset = GetTranscodedMediaOffset(keyPathLength);
+	if (
+		Utils::ReadLe32(header) != transcodedMediaMagic
+		|| Utils::ReadLe32(header + 4) != transcodedMediaVersion
+		|| Utils::ReadLe64(header + 8) != sourceSize
+		|| Utils::ReadLe64(header + 16) != sourceLastWriteTime
+		|| keyPathLength != keyPath.size()
+		|| mediaSize == 0
+		|| file->Size() != mediaOffset + static_cast<uint64_t>(mediaSize)
+	)
+	{
+		return false;
+	}
+
+	std::string storedKeyPath(keyPathLength, '\0');
+	if (!file->Read(transcodedMediaHeaderSize, &storedKeyPath[0], keyPathLength) || storedKeyPath != keyPath)
+	{
+		return false;
+	}
+
+	media = {};
+	media.path = sourcePath;
+	media.mappedBytes = file->Data() + mediaOffset;
+	media.mappedSize = mediaSize;
+	TrackMappedEntry(path, file);
+	media.mappedFile = std::move(file);
+	media.durationMs = static_cast<long long>(Utils::ReadLe64(header + 24));
+	media.sourcePluginId = Utils::ReadLe32(header + 32);
+	media.sampleRate = Utils::ReadLe32(header + 36);
+	media.channels = Utils::ReadLe32(header + 40);
+	media.bitsPerSample = Utils::ReadLe32(header + 44);
+	media.decodedToPcm = (Utils::ReadLe32(header + 56) & transcodedMediaDecodedToPcmFlag) != 0;
+	MarkRecentlyUsed(path);
+	return true;
+}
+
+bool MediaCache::StoreTranscodedMedia(const std::string& sourcePath, const AudioDecoder::WwiseMediaBuffer& media)
+{
+	const std::string keyPath = GetTranscodeKeyPath(sourcePath);
+	const std::wstring path = GetTranscodedMediaPath(keyPath);
+	const size_t mediaOffset = GetTranscodedMediaOffset(keyPath.size());
+	uint64_t sourceSize = 0;
+	uint64_t sourceLastWriteTime = 0;
+	if (
+		path.empty()
+		|| media.Size() == 0
+		|| media.Size() > (std::numeric_limits<uint32_t>::max)()
+		|| mediaOffset + static_cast<uint64_t>(media.Size()) > GetTranscodeCacheBudget()
+		// The rename onto a mapped entry would fail, so do not evict anything for it.
+		|| IsEntryMapped(path)
+		|| !Utils::GetFileSizeAndWriteTime(Utils::ToWidePath(sourcePath), sourceSize, sourceLastWriteTime)
+		|| !CreateDirectoryIfMissing(GetCacheDirectory())
+		|| !CreateDirectoryIfMissing(GetTranscodeDirectory())
+	)
+	{
+		return false;
+	}
+
+	EvictTranscodedMedia(GetTranscodeDirectory(), path, mediaOffset + media.Size());
+
+	std::vector<uint8_t> header;
+	header.reserve(mediaOffset);
+	Utils::AppendLe32(header, transcodedMediaMagic);
+	Utils::AppendLe32(header, transcodedMediaVersion);
+	Utils::AppendLe64(header, sourceSize);
+	Utils::AppendLe64(header, sourceLastWriteTime);
+	Utils::AppendLe64(header, static_cast<uint64_t>(media.durationMs));
+	Utils::AppendLe32(header, media.sourcePluginId);
+	Utils::AppendLe32(header, media.sampleRate);
+	Utils::AppendLe32(header, media.channels);
+	Utils::AppendLe32(header, media.bitsPerSample);
+	Utils::AppendLe32(header, static_cast<uint32_t>(media.Size()));
+	Utils::AppendLe32(header, static_cast<uint32_t>(keyPath.size()));
+	Utils::AppendLe32(header, media.decodedToPcm ? transcodedMediaDecodedToPcmFlag : 0);
+	Utils::AppendLe32(header, 0);
+	header.insert(header.end(), keyPath.begin(), keyPath.end());
+	header.resize(mediaOffset, 0);
+	return WriteTranscodedMediaFile(path, header, media.Data(), media.Size());
+}
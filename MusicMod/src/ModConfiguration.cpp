@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cstdint>
 #include <exception>
 #include <filesystem>
@@ -11,11 +12,13 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "ordered_set.h"
 
 #include "AudioDecoder.h"
+#include "DecimaHash.h"
 #include "GameData.h"
 
 #include "MemoryUtils.h"
@@ -23,6 +26,32 @@
 
 namespace
 {
+	// Settings that take a whole number instead of a toggle
+	const std::unordered_set<std::string> numericSettings =
+	{
+		"archiveChunkCacheSizeMB",
+		"transcodeCacheSizeMB"
+	};
+
+	bool IsUnsignedSettingValue(const std::string& value)
+	{
+		return !value.empty()
+			&& value.size() <= 6
+			&& std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c) != 0; });
+	}
+
+	// Leaves setting untouched unless value is a whole number that fits, so a bad line keeps the default.
+	void SetUnsignedSetting(const std::string& value, uint32_t& setting)
+	{
+		uint32_t parsed = 0;
+		const char* end = value.data() + value.size();
+		const std::from_chars_result result = std::from_chars(value.data(), end, parsed);
+		if (result.ec == std::errc() && result.ptr == end)
+		{
+			setting = parsed;
+		}
+	}
+
 	MusicData MakeInternalWwiseAreaTrack(
 		uint16_t descriptionID,
 		long long durationMs,
@@ -43,6 +72,8 @@ namespace
 		data.exclusiveDC = exclusiveDC;
 		data.customAreaTrack = true;
 		data.internalWwiseAreaTrack = internalWwiseAreaTrack;
+		data.internalWwiseAreaTrack.streamPathHash =
+			DecimaHash::ComputeStreamedWemPathHash(internalWwiseAreaTrack.sourceId);
 		return data;
 	}
 }
@@ -63,6 +94,7 @@ namespace ModConfiguration
 	{
 		{ "[Global Settings]", Section::GLOBAL_SETTINGS },
 		{ "[Playlist]", Section::ACTIVE_SONGS },
+		{ "[Compressed Songs]", Section::COMPRESSED_SONGS },
 	};
 
 	// Mod configuration defaults
@@ -79,10 +111,16 @@ namespace ModConfiguration
 
 	bool customSongsEnabled = true;
 	std::string customSongsFolderPath = "";
+	bool compressCustomSongs = false;
 
 	bool allowScriptedSongs = true;
 	bool showMusicPlayerUI = true;
 
+	uint32_t archiveChunkCacheSizeMB = 32;
+	uint32_t transcodeCacheSizeMB = 2048;
+
+	bool runBenchmarks = false;
+
 	// Default ordered playlist
 	tsl::ordered_set<std::string> activePlaylist =
 	{
@@ -94,6 +132,8 @@ namespace ModConfiguration
 		"Waiting (10 Years)", "Nobody Else", "Asylums For The Feeling", "Almost Nothing", "BB's Theme"
 	};
 
+	std::unordered_set<std::string> compressedSongs{};
+
 	// Maps global setting names to lambda setter functions
 	const std::unordered_map<std::string, std::function<void(const std::string&)>> parameterSetters =
 	{
@@ -124,11 +164,23 @@ namespace ModConfiguration
 		{"customSongsFolderPath",
 		[](const std::string& val) { customSongsFolderPath = val; }},
 
+		{"compressCustomSongs",
+		[](const std::string& val) { compressCustomSongs = (val == "true" || val == "1"); }},
+
 		{"allowScriptedSongs",
 		[](const std::string& val) { allowScriptedSongs = (val == "true" || val == "1"); }},
 
 		{"showMusicPlayerUI",
 		[](const std::string& val) { showMusicPlayerUI = (val == "true" || val == "1"); }},
+
+		{"archiveChunkCacheSizeMB",
+		[](const std::string& val) { SetUnsignedSetting(val, archiveChunkCacheSizeMB); }},
+
+		{"transcodeCacheSizeMB",
+		[](const std::string& val) { SetUnsignedSetting(val, transcodeCacheSizeMB); }},
+
+		{"runBenchmarks",
+		[](const std::string& val) { runBenchmarks = (val == "true" || val == "1"); }},
 	};
 
 	bool LoadConfigFromFile()
@@ -185,10 +237,11 @@ namespace ModConfiguration
 						break;
 					}
 
-					if (
-							key != "customSongsFolderPath"
-							&& val != "true" && val != "false" && val != "1" && val != "0"
-					)
+					const bool validValue = key == "customSongsFolderPath"
+						|| (numericSettings.count(key) != 0
+							? IsUnsignedSettingValue(val)
+							: val == "true" || val == "false" || val == "1" || val == "0");
+					if (!validValue)
 					{
 						std::string errorMessage = "Invalid value for setting "
 							+ key + " (" + val + ")"
@@ -206,6 +259,11 @@ namespace ModConfiguration
 					break;
 				}
 				case Section::INACTIVE_SONGS: break;
+				case Section::COMPRESSED_SONGS:
+				{
+					compressedSongs.insert(line);
+					break;
+				}
 				default: break;
 			}
 		}
@@ -9,7 +9,9 @@
 #include "Utils.h"
 
 #include "CustomMediaLoader.h"
+#include "DecimaArchiveReader.h"
 #include "ModConfiguration.h"
+#include "SimdKernels.h"
 
 #include "GameData.h"
 
@@ -271,6 +273,12 @@ void ModManager::OnRender()
 					instance->DispatchEvent(ModEvent{ ModEventType::ScanCompleted, nullptr, nullptr });
 				}
 				Logging::Write(logPrefix, "Setup complete");
+
+				if (ModConfiguration::runBenchmarks)
+				{
+					SimdKernels::LogBenchmarks();
+					DecimaArchiveReader::LogBenchmarks();
+				}
 			},
 			&scanProgress,
 			PAGE_READWRITE,
@@ -56,6 +56,7 @@ void MusicPlayer::CancelPendingAreaMusicTransition(const char* reason)
 	pendingMusicData = nullptr;
 	pendingMusicDisplayDescription = true;
 	pendingMusicOverridePrepared = false;
+	pendingMusicResumeOffsetMs = 0;
 	currentMusicPlayTime.store(0);
 	currentMusicMaxLength.store(0);
 	ResetCurrentMusicCursor();
@@ -533,6 +534,12 @@ void MusicPlayer::OnRender()
 				});
 			}
 
+			// The decode service is still working on the media; poll again next frame.
+			if (registration.pending)
+			{
+				return;
+			}
+
 			if (!registration.handled || !registration.success)
 			{
 				Logging::Write(logPrefix,
@@ -542,6 +549,7 @@ void MusicPlayer::OnRender()
 				pendingMusicData = nullptr;
 				pendingMusicDisplayDescription = true;
 				pendingMusicOverridePrepared = false;
+				pendingMusicResumeOffsetMs = 0;
 				if (ModManager* instance = ModManager::GetInstance())
 				{
 					instance->DispatchEvent(ModEvent{ ModEventType::AreaMusicUnsetRequested, nullptr, nullptr });
@@ -561,11 +569,13 @@ void MusicPlayer::OnRender()
 			return;
 		}
 
+		const long long resumeOffsetMs = pendingMusicResumeOffsetMs;
 		pendingMusicData = nullptr;
 		pendingMusicDisplayDescription = true;
 		pendingMusicOverridePrepared = false;
+		pendingMusicResumeOffsetMs = 0;
 		Logging::Write(logPrefix, "Starting queued area music track: %s", data->name);
-		PlayMusic(data, displayDescription);
+		PlayMusic(data, displayDescription, resumeOffsetMs);
 	}
 
 	// Handle Playback
@@ -1490,6 +1500,7 @@ bool MusicPlayer::QueueAreaMusicTransition(const MusicData* data, bool displayDe
 	pendingMusicData = data;
 	pendingMusicDisplayDescription = displayDescription;
 	pendingMusicOverridePrepared = false;
+	pendingMusicResumeOffsetMs = 0;
 	pendingMusicStartTime = std::chrono::steady_clock::now();
 	return true;
 }
@@ -1701,6 +1712,22 @@ void MusicPlayer::PlayMusic(const MusicData* data, bool displayDescription, long
 			});
 		}
 
+		// Hand the track to OnRender, which polls until the decode finishes and then plays it. The current
+		// music keeps going meanwhile, and the description has already been shown.
+		if (registration.pending)
+		{
+			Logging::Write(logPrefix,
+				"Area music override for \"%s\" is still decoding; playback starts when it is ready",
+				data->name ? data->name : ""
+			);
+			pendingMusicData = data;
+			pendingMusicDisplayDescription = false;
+			pendingMusicOverridePrepared = false;
+			pendingMusicResumeOffsetMs = resumeOffsetMs;
+			pendingMusicStartTime = std::chrono::steady_clock::now();
+			return;
+		}
+
 		if (!registration.handled || !registration.success)
 		{
 			Logging::Write(logPrefix,
@@ -0,0 +1,248 @@
+#include "PcmFileParser.h"
+
+#include <cstring>
+
+namespace
+{
+	// Every other decode path hands Wwise 16-bit samples, so the fast path does not widen what it has to play.
+	constexpr uint32_t supportedBitsPerSample = 16;
+	constexpr uint32_t maxChannels = 8;
+	constexpr uint16_t waveFormatPcm = 1;
+	constexpr uint16_t waveFormatExtensible = 0xfffe;
+
+	const uint8_t pcmSubFormatGuid[16] = {
+		0x01, 0x00, 0x00, 0x00,
+		0x00, 0x00,
+		0x10, 0x00,
+		0x80, 0x00,
+		0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
+	};
+
+	uint16_t ReadLe16(const uint8_t* bytes)
+	{
+		return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+	}
+
+	uint32_t ReadLe32(const uint8_t* bytes)
+	{
+		return static_cast<uint32_t>(bytes[0])
+			| (static_cast<uint32_t>(bytes[1]) << 8)
+			| (static_cast<uint32_t>(bytes[2]) << 16)
+			| (static_cast<uint32_t>(bytes[3]) << 24);
+	}
+
+	uint16_t ReadBe16(const uint8_t* bytes)
+	{
+		return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+	}
+
+	uint32_t ReadBe32(const uint8_t* bytes)
+	{
+		return (static_cast<uint32_t>(bytes[0]) << 24)
+			| (static_cast<uint32_t>(bytes[1]) << 16)
+			| (static_cast<uint32_t>(bytes[2]) << 8)
+			| static_cast<uint32_t>(bytes[3]);
+	}
+
+	bool HasId(const uint8_t* bytes, const char* id)
+	{
+		return std::memcmp(bytes, id, 4) == 0;
+	}
+
+	// AIFF stores the sample rate as an 80-bit IEEE extended float; only whole rates are accepted.
+	bool ReadExtendedSampleRate(const uint8_t* bytes, uint32_t& sampleRate)
+	{
+		const uint16_t signAndExponent = ReadBe16(bytes);
+		const uint64_t mantissa = (static_cast<uint64_t>(ReadBe32(bytes + 2)) << 32) | ReadBe32(bytes + 6);
+		const int exponent = static_cast<int>(signAndExponent & 0x7fff) - 16383;
+		if ((signAndExponent & 0x8000) != 0 || exponent < 0 || exponent > 31)
+		{
+			return false;
+		}
+
+		const int shift = 63 - exponent;
+		if ((mantissa & ((1ull << shift) - 1)) != 0)
+		{
+			return false;
+		}
+		sampleRate = static_cast<uint32_t>(mantissa >> shift);
+		return sampleRate != 0;
+	}
+
+	bool FinishLayout(PcmFileParser::PcmLayout& layout, size_t size)
+	{
+		if (
+			layout.channels == 0
+			|| layout.channels > maxChannels
+			|| layout.sampleRate == 0
+			|| layout.bitsPerSample != supportedBitsPerSample
+			|| layout.dataOffset > size
+		)
+		{
+			return false;
+		}
+
+		const size_t frameSize = static_cast<size_t>(layout.channels) * (layout.bitsPerSample / 8);
+		if (layout.dataSize > size - layout.dataOffset)
+		{
+			layout.dataSize = size - layout.dataOffset;
+		}
+		layout.dataSize -= layout.dataSize % frameSize;
+		return layout.dataSize != 0;
+	}
+
+	bool ReadWaveFormat(const uint8_t* format, uint32_t formatSize, PcmFileParser::PcmLayout& layout)
+	{
+		if (formatSize < 16)
+		{
+			return false;
+		}
+
+		const uint16_t formatTag = ReadLe16(format);
+		layout.channels = ReadLe16(format + 2);
+		layout.sampleRate = ReadLe32(format + 4);
+		layout.bitsPerSample = ReadLe16(format + 14);
+		if (formatTag == waveFormatPcm)
+		{
+			return true;
+		}
+		if (formatTag != waveFormatExtensible || formatSize < 40)
+		{
+			return false;
+		}
+
+		// Samples padded inside a wider container would need shifting, so only full-width samples are accepted.
+		const uint16_t validBitsPerSample = ReadLe16(format + 18);
+		layout.channelMask = ReadLe32(format + 20);
+		return (validBitsPerSample == 0 || validBitsPerSample == layout.bitsPerSample)
+			&& std::memcmp(format + 24, pcmSubFormatGuid, sizeof(pcmSubFormatGuid)) == 0;
+	}
+
+	bool ParseWave(const uint8_t* bytes, size_t size, PcmFileParser::PcmLayout& layout)
+	{
+		bool hasFormat = false;
+		bool hasData = false;
+		size_t offset = 12;
+		while (offset + 8 <= size && !(hasFormat && hasData))
+		{
+			const uint32_t chunkSize = ReadLe32(bytes + offset + 4);
+			const size_t dataOffset = offset + 8;
+			const bool truncated = chunkSize > size - dataOffset;
+			if (HasId(bytes + offset, "data"))
+			{
+				layout.dataOffset = dataOffset;
+				layout.dataSize = chunkSize;
+				hasData = true;
+			}
+			else if (HasId(bytes + offset, "fmt "))
+			{
+				if (truncated || !ReadWaveFormat(bytes + dataOffset, chunkSize, layout))
+				{
+					return false;
+				}
+				hasFormat = true;
+			}
+
+			if (truncated)
+			{
+				break;
+			}
+			offset = dataOffset + chunkSize + (chunkSize & 1);
+		}
+
+		return hasFormat && hasData && FinishLayout(layout, size);
+	}
+
+	bool ParseAiff(const uint8_t* bytes, size_t size, PcmFileParser::PcmLayout& layout)
+	{
+		const bool isAifc = HasId(bytes + 8, "AIFC");
+		bool hasCommon = false;
+		bool hasSound = false;
+		uint32_t frameCount = 0;
+		size_t offset = 12;
+		while (offset + 8 <= size && !(hasCommon && hasSound))
+		{
+			const uint32_t chunkSize = ReadBe32(bytes + offset + 4);
+			const size_t dataOffset = offset + 8;
+			const bool truncated = chunkSize > size - dataOffset;
+			const uint8_t* chunk = bytes + dataOffset;
+			if (HasId(bytes + offset, "COMM"))
+			{
+				if (
+					truncated
+					|| chunkSize < (isAifc ? 22u : 18u)
+					|| !ReadExtendedSampleRate(chunk + 8, layout.sampleRate)
+				)
+				{
+					return false;
+				}
+				layout.channels = ReadBe16(chunk);
+				frameCount = ReadBe32(chunk + 2);
+				layout.bitsPerSample = ReadBe16(chunk + 6);
+				layout.bigEndian = true;
+				if (isAifc)
+				{
+					// "sowt" is the little-endian variant some encoders write; anything else is compressed.
+					if (HasId(chunk + 18, "sowt"))
+					{
+						layout.bigEndian = false;
+					}
+					else if (!HasId(chunk + 18, "NONE") && !HasId(chunk + 18, "twos"))
+					{
+						return false;
+					}
+				}
+				hasCommon = true;
+			}
+			else if (HasId(bytes + offset, "SSND"))
+			{
+				// The samples start after an offset/block size pair and any alignment padding the offset skips.
+				if (chunkSize < 8 || size - dataOffset < 8 || ReadBe32(chunk) > chunkSize - 8)
+				{
+					return false;
+				}
+				const uint32_t soundOffset = ReadBe32(chunk);
+				layout.dataOffset = dataOffset + 8 + soundOffset;
+				layout.dataSize = chunkSize - 8 - soundOffset;
+				hasSound = true;
+			}
+
+			if (truncated)
+			{
+				break;
+			}
+			offset = dataOffset + chunkSize + (chunkSize & 1);
+		}
+
+		if (!hasCommon || !hasSound)
+		{
+			return false;
+		}
+
+		const uint64_t frameBytes = static_cast<uint64_t>(frameCount) * layout.channels * (layout.bitsPerSample / 8);
+		if (frameBytes < layout.dataSize)
+		{
+			layout.dataSize = static_cast<size_t>(frameBytes);
+		}
+		return FinishLayout(layout, size);
+	}
+}
+
+bool PcmFileParser::Parse(const uint8_t* bytes, size_t size, PcmLayout& layout)
+{
+	layout = {};
+	if (!bytes || size < 12)
+	{
+		return false;
+	}
+
+	if (HasId(bytes, "RIFF") && HasId(bytes + 8, "WAVE"))
+	{
+		return ParseWave(bytes, size, layout);
+	}
+	if (HasId(bytes, "FORM") && (HasId(bytes + 8, "AIFF") || HasId(bytes + 8, "AIFC")))
+	{
+		return ParseAiff(bytes, size, layout);
+	}
+	return false;
+}
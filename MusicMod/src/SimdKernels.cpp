@@ -0,0 +1,1032 @@
+#include "SimdKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <intrin.h>
+#include <immintrin.h>
+#include <vector>
+
+#include "Logger.h"
+
+namespace
+{
+	constexpr const char* logPrefix = "SIMD Kernels";
+
+	using XorRepeatingKey16Fn = void(*)(const uint8_t*, uint8_t*, size_t, const uint8_t*);
+	using MurmurHash3Keys16Fn = void(*)(const uint8_t*, size_t, uint32_t, uint64_t*);
+	using ByteSwap16Fn = void(*)(const uint8_t*, uint8_t*, size_t);
+	using WidenToFloatFn = void(*)(const uint8_t*, float*, size_t);
+	using FloatToInt16DitheredFn = void(*)(const float*, uint8_t*, size_t, uint32_t);
+
+	constexpr uint64_t murmurC1 = 0x87c37b91114253d5ull;
+	constexpr uint64_t murmurC2 = 0x4cf5ad432745937full;
+	constexpr uint64_t murmurFmix1 = 0xff51afd7ed558ccdull;
+	constexpr uint64_t murmurFmix2 = 0xc4ceb9fe1a85ec53ull;
+
+	constexpr float int16ToFloatScale = 1.0f / 32768.0f;
+	constexpr float int24ToFloatScale = 1.0f / 8388608.0f;
+	constexpr float int32ToFloatScale = 1.0f / 2147483648.0f;
+	constexpr float floatToInt16Scale = 32768.0f;
+	constexpr float ditherScale = 1.0f / 65536.0f;
+	// lowbias32 constants; the first spreads consecutive positions before hashing.
+	constexpr uint32_t ditherSpread = 0x9e3779b9u;
+	constexpr uint32_t ditherMix1 = 0x7feb352du;
+	constexpr uint32_t ditherMix2 = 0x846ca68bu;
+
+	void XorRepeatingKey16Scalar(const uint8_t* source, uint8_t* target, size_t size, const uint8_t* key)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			target[i] = source[i] ^ key[i & 15];
+		}
+	}
+
+	// Every 16-byte step keeps the key phase at zero, so the tail can reuse the scalar loop from offset i.
+	void XorRepeatingKey16Sse2(const uint8_t* source, uint8_t* target, size_t size, const uint8_t* key)
+	{
+		const __m128i keyLane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+		size_t i = 0;
+		for (; i + 64 <= size; i += 64)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 16));
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 32));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 48));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_xor_si128(a, keyLane));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i + 16), _mm_xor_si128(b, keyLane));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i + 32), _mm_xor_si128(c, keyLane));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i + 48), _mm_xor_si128(d, keyLane));
+		}
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_xor_si128(a, keyLane));
+		}
+		XorRepeatingKey16Scalar(source + i, target + i, size - i, key);
+	}
+
+	void XorRepeatingKey16Avx2(const uint8_t* source, uint8_t* target, size_t size, const uint8_t* key)
+	{
+		const __m128i keyHalf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+		const __m256i keyLane = _mm256_broadcastsi128_si256(keyHalf);
+		size_t i = 0;
+		for (; i + 128 <= size; i += 128)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 32));
+			const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 64));
+			const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 96));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i), _mm256_xor_si256(a, keyLane));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i + 32), _mm256_xor_si256(b, keyLane));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i + 64), _mm256_xor_si256(c, keyLane));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i + 96), _mm256_xor_si256(d, keyLane));
+		}
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i), _mm256_xor_si256(a, keyLane));
+		}
+		XorRepeatingKey16Sse2(source + i, target + i, size - i, key);
+	}
+
+	uint64_t Rotl64(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	uint64_t Fmix64(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= murmurFmix1;
+		value ^= value >> 33;
+		value *= murmurFmix2;
+		value ^= value >> 33;
+		return value;
+	}
+
+	uint64_t LoadLe64(const uint8_t* bytes)
+	{
+		uint64_t value;
+		std::memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	// A 16-byte key is exactly one MurmurHash3 block with no tail.
+	void MurmurHash3X64_128Keys16Scalar(const uint8_t* keys, size_t count, uint32_t seed, uint64_t* hashes)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t k1 = LoadLe64(keys + i * 16);
+			uint64_t k2 = LoadLe64(keys + i * 16 + 8);
+			uint64_t h1 = seed;
+			uint64_t h2 = seed;
+
+			k1 *= murmurC1;
+			k1 = Rotl64(k1, 31);
+			k1 *= murmurC2;
+			h1 ^= k1;
+			h1 = Rotl64(h1, 27);
+			h1 += h2;
+			h1 = h1 * 5 + 0x52dce729;
+
+			k2 *= murmurC2;
+			k2 = Rotl64(k2, 33);
+			k2 *= murmurC1;
+			h2 ^= k2;
+			h2 = Rotl64(h2, 31);
+			h2 += h1;
+			h2 = h2 * 5 + 0x38495ab5;
+
+			h1 ^= 16;
+			h2 ^= 16;
+			h1 += h2;
+			h2 += h1;
+			h1 = Fmix64(h1);
+			h2 = Fmix64(h2);
+			h1 += h2;
+			h2 += h1;
+
+			hashes[i * 2] = h1;
+			hashes[i * 2 + 1] = h2;
+		}
+	}
+
+	// AVX2 has no 64-bit multiply, so build it from three 32x32->64 products; the high x high term
+	// only affects bits above 64.
+	__m256i Mul64Avx2(__m256i value, __m256i factor, __m256i factorHigh)
+	{
+		const __m256i low = _mm256_mul_epu32(value, factor);
+		const __m256i cross = _mm256_add_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(value, 32), factor),
+			_mm256_mul_epu32(value, factorHigh)
+		);
+		return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+	}
+
+	template <int bits>
+	__m256i Rotl64Avx2(__m256i value)
+	{
+		return _mm256_or_si256(_mm256_slli_epi64(value, bits), _mm256_srli_epi64(value, 64 - bits));
+	}
+
+	__m256i Fmix64Avx2(__m256i value)
+	{
+		const __m256i fmix1 = _mm256_set1_epi64x(static_cast<long long>(murmurFmix1));
+		const __m256i fmix1High = _mm256_set1_epi64x(static_cast<long long>(murmurFmix1 >> 32));
+		const __m256i fmix2 = _mm256_set1_epi64x(static_cast<long long>(murmurFmix2));
+		const __m256i fmix2High = _mm256_set1_epi64x(static_cast<long long>(murmurFmix2 >> 32));
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 33));
+		value = Mul64Avx2(value, fmix1, fmix1High);
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 33));
+		value = Mul64Avx2(value, fmix2, fmix2High);
+		return _mm256_xor_si256(value, _mm256_srli_epi64(value, 33));
+	}
+
+	// Four keys per vector. The in-lane unpacks leave the lanes in key order 0, 2, 1, 3, and the matching
+	// unpacks on the way out put them back.
+	void MurmurHash3X64_128Keys16Avx2(const uint8_t* keys, size_t count, uint32_t seed, uint64_t* hashes)
+	{
+		const __m256i c1 = _mm256_set1_epi64x(static_cast<long long>(murmurC1));
+		const __m256i c1High = _mm256_set1_epi64x(static_cast<long long>(murmurC1 >> 32));
+		const __m256i c2 = _mm256_set1_epi64x(static_cast<long long>(murmurC2));
+		const __m256i c2High = _mm256_set1_epi64x(static_cast<long long>(murmurC2 >> 32));
+		const __m256i seedLane = _mm256_set1_epi64x(seed);
+		const __m256i add1 = _mm256_set1_epi64x(0x52dce729);
+		const __m256i add2 = _mm256_set1_epi64x(0x38495ab5);
+		const __m256i length = _mm256_set1_epi64x(16);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i * 16));
+			const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i * 16 + 32));
+			__m256i k1 = _mm256_unpacklo_epi64(first, second);
+			__m256i k2 = _mm256_unpackhi_epi64(first, second);
+
+			k1 = Mul64Avx2(k1, c1, c1High);
+			k1 = Rotl64Avx2<31>(k1);
+			k1 = Mul64Avx2(k1, c2, c2High);
+			__m256i h1 = _mm256_xor_si256(seedLane, k1);
+			h1 = Rotl64Avx2<27>(h1);
+			h1 = _mm256_add_epi64(h1, seedLane);
+			h1 = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(h1, 2), h1), add1);
+
+			k2 = Mul64Avx2(k2, c2, c2High);
+			k2 = Rotl64Avx2<33>(k2);
+			k2 = Mul64Avx2(k2, c1, c1High);
+			__m256i h2 = _mm256_xor_si256(seedLane, k2);
+			h2 = Rotl64Avx2<31>(h2);
+			h2 = _mm256_add_epi64(h2, h1);
+			h2 = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(h2, 2), h2), add2);
+
+			h1 = _mm256_xor_si256(h1, length);
+			h2 = _mm256_xor_si256(h2, length);
+			h1 = _mm256_add_epi64(h1, h2);
+			h2 = _mm256_add_epi64(h2, h1);
+			h1 = Fmix64Avx2(h1);
+			h2 = Fmix64Avx2(h2);
+			h1 = _mm256_add_epi64(h1, h2);
+			h2 = _mm256_add_epi64(h2, h1);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + i * 2), _mm256_unpacklo_epi64(h1, h2));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + i * 2 + 4), _mm256_unpackhi_epi64(h1, h2));
+		}
+		MurmurHash3X64_128Keys16Scalar(keys + i * 16, count - i, seed, hashes + i * 2);
+	}
+
+	void ByteSwap16Scalar(const uint8_t* source, uint8_t* target, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint8_t low = source[i * 2];
+			target[i * 2] = source[i * 2 + 1];
+			target[i * 2 + 1] = low;
+		}
+	}
+
+	// SSE2 has no byte shuffle, but shifting each 16-bit lane both ways and merging swaps its bytes just as well.
+	void ByteSwap16Sse2(const uint8_t* source, uint8_t* target, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2 + 16));
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(target + i * 2),
+				_mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8))
+			);
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(target + i * 2 + 16),
+				_mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8))
+			);
+		}
+		ByteSwap16Scalar(source + i * 2, target + i * 2, count - i);
+	}
+
+	void ByteSwap16Avx2(const uint8_t* source, uint8_t* target, size_t count)
+	{
+		const __m256i swapMask = _mm256_setr_epi8(
+			1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+			1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+		);
+		size_t i = 0;
+		for (; i + 64 <= count; i += 64)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 2));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 2 + 32));
+			const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 2 + 64));
+			const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 2 + 96));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i * 2), _mm256_shuffle_epi8(a, swapMask));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i * 2 + 32), _mm256_shuffle_epi8(b, swapMask));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i * 2 + 64), _mm256_shuffle_epi8(c, swapMask));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i * 2 + 96), _mm256_shuffle_epi8(d, swapMask));
+		}
+		ByteSwap16Sse2(source + i * 2, target + i * 2, count - i);
+	}
+
+	void Int16ToFloatScalar(const uint8_t* source, float* target, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const int16_t sample = static_cast<int16_t>(source[i * 2] | (source[i * 2 + 1] << 8));
+			target[i] = static_cast<float>(sample) * int16ToFloatScale;
+		}
+	}
+
+	// Unpacking each sample into the top half of a 32-bit lane and shifting it back down sign-extends it.
+	void Int16ToFloatSse2(const uint8_t* source, float* target, size_t count)
+	{
+		const __m128 scale = _mm_set1_ps(int16ToFloatScale);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+			const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+			const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+			_mm_storeu_ps(target + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+			_mm_storeu_ps(target + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+		}
+		Int16ToFloatScalar(source + i * 2, target + i, count - i);
+	}
+
+	void Int16ToFloatAvx2(const uint8_t* source, float* target, size_t count)
+	{
+		const __m256 scale = _mm256_set1_ps(int16ToFloatScale);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+			const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2 + 16));
+			_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(low)), scale));
+			_mm256_storeu_ps(target + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(high)), scale));
+		}
+		Int16ToFloatSse2(source + i * 2, target + i, count - i);
+	}
+
+	int32_t ReadInt24(const uint8_t* bytes)
+	{
+		const uint32_t shifted = (static_cast<uint32_t>(bytes[0]) << 8)
+			| (static_cast<uint32_t>(bytes[1]) << 16)
+			| (static_cast<uint32_t>(bytes[2]) << 24);
+		return static_cast<int32_t>(shifted) >> 8;
+	}
+
+	// SSE2 has no byte shuffle to unpack 3-byte samples with, so this is also the SSE2 path.
+	void Int24ToFloatScalar(const uint8_t* source, float* target, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			target[i] = static_cast<float>(ReadInt24(source + i * 3)) * int24ToFloatScale;
+		}
+	}
+
+	// Each 128-bit half moves four 3-byte samples into the top of its 32-bit lanes, where an arithmetic shift
+	// sign-extends them.
+	void Int24ToFloatAvx2(const uint8_t* source, float* target, size_t count)
+	{
+		const __m256i spread = _mm256_setr_epi8(
+			-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+			-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+		);
+		const __m256 scale = _mm256_set1_ps(int24ToFloatScale);
+		size_t i = 0;
+		// The upper load reads 4 bytes past the samples it converts, which the loop bound leaves room for.
+		for (; i + 10 <= count; i += 8)
+		{
+			const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+			const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3 + 12));
+			const __m256i packed = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+			const __m256i samples = _mm256_srai_epi32(_mm256_shuffle_epi8(packed, spread), 8);
+			_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+		}
+		Int24ToFloatScalar(source + i * 3, target + i, count - i);
+	}
+
+	void Int32ToFloatScalar(const uint8_t* source, float* target, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			int32_t sample = 0;
+			std::memcpy(&sample, source + i * 4, sizeof(sample));
+			target[i] = static_cast<float>(sample) * int32ToFloatScale;
+		}
+	}
+
+	void Int32ToFloatSse2(const uint8_t* source, float* target, size_t count)
+	{
+		const __m128 scale = _mm_set1_ps(int32ToFloatScale);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4 + 16));
+			_mm_storeu_ps(target + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+			_mm_storeu_ps(target + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+		}
+		Int32ToFloatScalar(source + i * 4, target + i, count - i);
+	}
+
+	void Int32ToFloatAvx2(const uint8_t* source, float* target, size_t count)
+	{
+		const __m256 scale = _mm256_set1_ps(int32ToFloatScale);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4 + 32));
+			_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+			_mm256_storeu_ps(target + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+		}
+		Int32ToFloatSse2(source + i * 4, target + i, count - i);
+	}
+
+	// Every sample's dither comes from hashing its position, so the vector paths produce exactly the scalar
+	// output no matter where a call starts.
+	uint32_t HashDitherPosition(uint32_t position)
+	{
+		uint32_t x = position * ditherSpread;
+		x ^= x >> 16;
+		x *= ditherMix1;
+		x ^= x >> 15;
+		x *= ditherMix2;
+		return x ^ (x >> 16);
+	}
+
+	// The difference of two uniform 16-bit values is triangular over (-1, 1) output steps.
+	float GetTriangularDither(uint32_t position)
+	{
+		const uint32_t bits = HashDitherPosition(position);
+		return static_cast<float>(static_cast<int32_t>(bits & 0xffff) - static_cast<int32_t>(bits >> 16))
+			* ditherScale;
+	}
+
+	// The comparisons mirror minps/maxps, including which operand a NaN sample resolves to.
+	void FloatToInt16DitheredScalar(const float* source, uint8_t* target, size_t count, uint32_t position)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float value = source[i] * floatToInt16Scale + GetTriangularDither(position + static_cast<uint32_t>(i));
+			value = value < 32767.0f ? value : 32767.0f;
+			value = value > -32768.0f ? value : -32768.0f;
+			const int32_t sample = _mm_cvtss_si32(_mm_set_ss(value));
+			target[i * 2] = static_cast<uint8_t>(sample);
+			target[i * 2 + 1] = static_cast<uint8_t>(sample >> 8);
+		}
+	}
+
+	// SSE2 only multiplies the even 32-bit lanes, so the odd ones go through a second multiply.
+	__m128i MulLo32Sse2(__m128i a, __m128i b)
+	{
+		const __m128i even = _mm_mul_epu32(a, b);
+		const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(
+			_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+			_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+		);
+	}
+
+	__m128 GetTriangularDitherSse2(__m128i position)
+	{
+		__m128i x = MulLo32Sse2(position, _mm_set1_epi32(static_cast<int>(ditherSpread)));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+		x = MulLo32Sse2(x, _mm_set1_epi32(static_cast<int>(ditherMix1)));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+		x = MulLo32Sse2(x, _mm_set1_epi32(static_cast<int>(ditherMix2)));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+		const __m128i difference = _mm_sub_epi32(_mm_and_si128(x, _mm_set1_epi32(0xffff)), _mm_srli_epi32(x, 16));
+		return _mm_mul_ps(_mm_cvtepi32_ps(difference), _mm_set1_ps(ditherScale));
+	}
+
+	void FloatToInt16DitheredSse2(const float* source, uint8_t* target, size_t count, uint32_t position)
+	{
+		const __m128 scale = _mm_set1_ps(floatToInt16Scale);
+		const __m128 maxValue = _mm_set1_ps(32767.0f);
+		const __m128 minValue = _mm_set1_ps(-32768.0f);
+		const __m128i step = _mm_set1_epi32(4);
+		__m128i positions = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(position)), _mm_setr_epi32(0, 1, 2, 3));
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + i), scale), GetTriangularDitherSse2(positions));
+			positions = _mm_add_epi32(positions, step);
+			__m128 b = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + i + 4), scale), GetTriangularDitherSse2(positions));
+			positions = _mm_add_epi32(positions, step);
+			a = _mm_max_ps(_mm_min_ps(a, maxValue), minValue);
+			b = _mm_max_ps(_mm_min_ps(b, maxValue), minValue);
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(target + i * 2),
+				_mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b))
+			);
+		}
+		FloatToInt16DitheredScalar(source + i, target + i * 2, count - i, position + static_cast<uint32_t>(i));
+	}
+
+	__m256 GetTriangularDitherAvx2(__m256i position)
+	{
+		__m256i x = _mm256_mullo_epi32(position, _mm256_set1_epi32(static_cast<int>(ditherSpread)));
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+		x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(ditherMix1)));
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+		x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(ditherMix2)));
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+		const __m256i difference = _mm256_sub_epi32(
+			_mm256_and_si256(x, _mm256_set1_epi32(0xffff)),
+			_mm256_srli_epi32(x, 16)
+		);
+		return _mm256_mul_ps(_mm256_cvtepi32_ps(difference), _mm256_set1_ps(ditherScale));
+	}
+
+	// packs works within each 128-bit half, so the 64-bit quarters are put back in order afterwards.
+	void FloatToInt16DitheredAvx2(const float* source, uint8_t* target, size_t count, uint32_t position)
+	{
+		const __m256 scale = _mm256_set1_ps(floatToInt16Scale);
+		const __m256 maxValue = _mm256_set1_ps(32767.0f);
+		const __m256 minValue = _mm256_set1_ps(-32768.0f);
+		const __m256i step = _mm256_set1_epi32(8);
+		__m256i positions = _mm256_add_epi32(
+			_mm256_set1_epi32(static_cast<int>(position)),
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+		);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256 a = _mm256_add_ps(
+				_mm256_mul_ps(_mm256_loadu_ps(source + i), scale),
+				GetTriangularDitherAvx2(positions)
+			);
+			positions = _mm256_add_epi32(positions, step);
+			__m256 b = _mm256_add_ps(
+				_mm256_mul_ps(_mm256_loadu_ps(source + i + 8), scale),
+				GetTriangularDitherAvx2(positions)
+			);
+			positions = _mm256_add_epi32(positions, step);
+			a = _mm256_max_ps(_mm256_min_ps(a, maxValue), minValue);
+			b = _mm256_max_ps(_mm256_min_ps(b, maxValue), minValue);
+			const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+			_mm256_storeu_si256(
+				reinterpret_cast<__m256i*>(target + i * 2),
+				_mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0))
+			);
+		}
+		FloatToInt16DitheredSse2(source + i, target + i * 2, count - i, position + static_cast<uint32_t>(i));
+	}
+
+	// Frames are padded to eight channels and summed in the same order as the SSE2 path, so both give identical
+	// results.
+	void DownmixToStereoScalar(
+		const float* source,
+		size_t frames,
+		uint32_t channels,
+		const float* coefficients,
+		float* target
+	)
+	{
+		float left[SimdKernels::maxDownmixChannels]{};
+		float right[SimdKernels::maxDownmixChannels]{};
+		std::memcpy(left, coefficients, channels * sizeof(float));
+		std::memcpy(right, coefficients + channels, channels * sizeof(float));
+		for (size_t frame = 0; frame < frames; frame++)
+		{
+			float samples[SimdKernels::maxDownmixChannels]{};
+			std::memcpy(samples, source + frame * channels, channels * sizeof(float));
+			float leftSums[4]{};
+			float rightSums[4]{};
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				leftSums[lane] = samples[lane] * left[lane] + samples[lane + 4] * left[lane + 4];
+				rightSums[lane] = samples[lane] * right[lane] + samples[lane + 4] * right[lane + 4];
+			}
+			target[frame * 2] = (leftSums[0] + leftSums[2]) + (leftSums[1] + leftSums[3]);
+			target[frame * 2 + 1] = (rightSums[0] + rightSums[2]) + (rightSums[1] + rightSums[3]);
+		}
+	}
+
+	// One frame fits two registers; both gains are applied at once and the four partial sums of each side are
+	// folded together with two shuffles. Eight floats per frame leave nothing for AVX2 to add. Loads run into the
+	// next frame and mask those lanes to zero, so only the last frame needs copying out first.
+	void DownmixToStereoSse2(
+		const float* source,
+		size_t frames,
+		uint32_t channels,
+		const float* coefficients,
+		float* target
+	)
+	{
+		alignas(16) float left[SimdKernels::maxDownmixChannels]{};
+		alignas(16) float right[SimdKernels::maxDownmixChannels]{};
+		alignas(16) uint32_t laneMask[SimdKernels::maxDownmixChannels]{};
+		std::memcpy(left, coefficients, channels * sizeof(float));
+		std::memcpy(right, coefficients + channels, channels * sizeof(float));
+		for (uint32_t lane = 0; lane < channels; lane++)
+		{
+			laneMask[lane] = 0xffffffffu;
+		}
+		const __m128 leftLow = _mm_load_ps(left);
+		const __m128 leftHigh = _mm_load_ps(left + 4);
+		const __m128 rightLow = _mm_load_ps(right);
+		const __m128 rightHigh = _mm_load_ps(right + 4);
+		const __m128 maskLow = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(laneMask)));
+		const __m128 maskHigh = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(laneMask + 4)));
+
+		const size_t sampleCount = frames * channels;
+		for (size_t frame = 0; frame < frames; frame++)
+		{
+			const float* samples = source + frame * channels;
+			alignas(16) float padded[SimdKernels::maxDownmixChannels]{};
+			if (frame * channels + SimdKernels::maxDownmixChannels > sampleCount)
+			{
+				std::memcpy(padded, samples, channels * sizeof(float));
+				samples = padded;
+			}
+			const __m128 low = _mm_and_ps(_mm_loadu_ps(samples), maskLow);
+			const __m128 high = _mm_and_ps(_mm_loadu_ps(samples + 4), maskHigh);
+
+			const __m128 leftSums = _mm_add_ps(_mm_mul_ps(low, leftLow), _mm_mul_ps(high, leftHigh));
+			const __m128 rightSums = _mm_add_ps(_mm_mul_ps(low, rightLow), _mm_mul_ps(high, rightHigh));
+			const __m128 pairs = _mm_add_ps(
+				_mm_unpacklo_ps(leftSums, rightSums),
+				_mm_unpackhi_ps(leftSums, rightSums)
+			);
+			_mm_storel_pi(reinterpret_cast<__m64*>(target + frame * 2), _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs)));
+		}
+	}
+
+	bool DetectAvx2()
+	{
+		int info[4]{};
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx)
+		{
+			return false;
+		}
+
+		// The OS must also save the YMM state across context switches.
+		if ((_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}
+
+	XorRepeatingKey16Fn SelectXorRepeatingKey16()
+	{
+		return SimdKernels::HasAvx2() ? XorRepeatingKey16Avx2 : XorRepeatingKey16Sse2;
+	}
+
+	MurmurHash3Keys16Fn SelectMurmurHash3Keys16()
+	{
+		return SimdKernels::HasAvx2() ? MurmurHash3X64_128Keys16Avx2 : MurmurHash3X64_128Keys16Scalar;
+	}
+
+	ByteSwap16Fn SelectByteSwap16()
+	{
+		return SimdKernels::HasAvx2() ? ByteSwap16Avx2 : ByteSwap16Sse2;
+	}
+
+	WidenToFloatFn SelectInt16ToFloat()
+	{
+		return SimdKernels::HasAvx2() ? Int16ToFloatAvx2 : Int16ToFloatSse2;
+	}
+
+	WidenToFloatFn SelectInt24ToFloat()
+	{
+		return SimdKernels::HasAvx2() ? Int24ToFloatAvx2 : Int24ToFloatScalar;
+	}
+
+	WidenToFloatFn SelectInt32ToFloat()
+	{
+		return SimdKernels::HasAvx2() ? Int32ToFloatAvx2 : Int32ToFloatSse2;
+	}
+
+	FloatToInt16DitheredFn SelectFloatToInt16Dithered()
+	{
+		return SimdKernels::HasAvx2() ? FloatToInt16DitheredAvx2 : FloatToInt16DitheredSse2;
+	}
+
+	double MeasureGigabytesPerSecond(XorRepeatingKey16Fn kernel, std::vector<uint8_t>& buffer, const uint8_t* key)
+	{
+		constexpr int passes = 16;
+		kernel(buffer.data(), buffer.data(), buffer.size(), key);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; pass++)
+		{
+			kernel(buffer.data(), buffer.data(), buffer.size(), key);
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() <= 0.0)
+		{
+			return 0.0;
+		}
+		return static_cast<double>(buffer.size()) * passes / elapsed.count() / 1e9;
+	}
+
+	double MeasureMillionHashesPerSecond(MurmurHash3Keys16Fn kernel, const std::vector<uint8_t>& keys)
+	{
+		constexpr int passes = 16;
+		const size_t count = keys.size() / 16;
+		std::vector<uint64_t> hashes(count * 2);
+		kernel(keys.data(), count, 0x2a, hashes.data());
+
+		const auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; pass++)
+		{
+			kernel(keys.data(), count, 0x2a, hashes.data());
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() <= 0.0)
+		{
+			return 0.0;
+		}
+		return static_cast<double>(count) * passes / elapsed.count() / 1e6;
+	}
+
+	double MeasureByteSwapGigabytesPerSecond(ByteSwap16Fn kernel, std::vector<uint8_t>& buffer)
+	{
+		constexpr int passes = 16;
+		const size_t count = buffer.size() / 2;
+		kernel(buffer.data(), buffer.data(), count);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; pass++)
+		{
+			kernel(buffer.data(), buffer.data(), count);
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() <= 0.0)
+		{
+			return 0.0;
+		}
+		return static_cast<double>(count * 2) * passes / elapsed.count() / 1e9;
+	}
+
+	template<typename Kernel>
+	double MeasureMillionSamplesPerSecond(Kernel kernel, size_t count)
+	{
+		constexpr int passes = 16;
+		kernel();
+
+		const auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; pass++)
+		{
+			kernel();
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() <= 0.0)
+		{
+			return 0.0;
+		}
+		return static_cast<double>(count) * passes / elapsed.count() / 1e6;
+	}
+}
+
+bool SimdKernels::HasAvx2()
+{
+	static const bool hasAvx2 = DetectAvx2();
+	return hasAvx2;
+}
+
+void SimdKernels::XorRepeatingKey16(const uint8_t* source, uint8_t* target, size_t size, const uint8_t key[16])
+{
+	static const XorRepeatingKey16Fn kernel = SelectXorRepeatingKey16();
+	kernel(source, target, size, key);
+}
+
+void SimdKernels::MurmurHash3X64_128Keys16(const uint8_t* keys, size_t count, uint32_t seed, uint64_t* hashes)
+{
+	static const MurmurHash3Keys16Fn kernel = SelectMurmurHash3Keys16();
+	kernel(keys, count, seed, hashes);
+}
+
+void SimdKernels::ByteSwap16(const uint8_t* source, uint8_t* target, size_t count)
+{
+	static const ByteSwap16Fn kernel = SelectByteSwap16();
+	kernel(source, target, count);
+}
+
+void SimdKernels::Int16ToFloat(const uint8_t* source, float* target, size_t count)
+{
+	static const WidenToFloatFn kernel = SelectInt16ToFloat();
+	kernel(source, target, count);
+}
+
+void SimdKernels::Int24ToFloat(const uint8_t* source, float* target, size_t count)
+{
+	static const WidenToFloatFn kernel = SelectInt24ToFloat();
+	kernel(source, target, count);
+}
+
+void SimdKernels::Int32ToFloat(const uint8_t* source, float* target, size_t count)
+{
+	static const WidenToFloatFn kernel = SelectInt32ToFloat();
+	kernel(source, target, count);
+}
+
+void SimdKernels::DownmixToStereo(
+	const float* source,
+	size_t frames,
+	uint32_t channels,
+	const float* coefficients,
+	float* target
+)
+{
+	if (channels == 0 || channels > maxDownmixChannels)
+	{
+		return;
+	}
+	DownmixToStereoSse2(source, frames, channels, coefficients, target);
+}
+
+void SimdKernels::FloatToInt16Dithered(const float* source, uint8_t* target, size_t count, uint32_t position)
+{
+	static const FloatToInt16DitheredFn kernel = SelectFloatToInt16Dithered();
+	kernel(source, target, count, position);
+}
+
+void SimdKernels::LogBenchmarks()
+{
+	constexpr size_t bufferSize = 16u * 1024u * 1024u;
+	std::vector<uint8_t> buffer(bufferSize);
+	for (size_t i = 0; i < buffer.size(); i++)
+	{
+		buffer[i] = static_cast<uint8_t>(i * 131u + 7u);
+	}
+
+	const uint8_t key[16] = {
+		0x37, 0xa2, 0x5c, 0x19, 0xe4, 0x0b, 0x8f, 0x63,
+		0xd1, 0x4e, 0x72, 0xbc, 0x05, 0x9a, 0xf8, 0x26
+	};
+
+	// An odd offset keeps the vector paths honest about unaligned loads and the scalar tail.
+	std::vector<uint8_t> reference(buffer.begin() + 3, buffer.end());
+	std::vector<uint8_t> vectorized = reference;
+	XorRepeatingKey16Scalar(reference.data(), reference.data(), reference.size(), key);
+	SimdKernels::XorRepeatingKey16(vectorized.data(), vectorized.data(), vectorized.size(), key);
+	if (std::memcmp(reference.data(), vectorized.data(), reference.size()) != 0)
+	{
+		Logging::Write(logPrefix, "XorRepeatingKey16 output does not match the scalar reference");
+	}
+
+	Logging::Write(logPrefix, "XorRepeatingKey16 scalar: %.2f GB/s",
+		MeasureGigabytesPerSecond(XorRepeatingKey16Scalar, buffer, key)
+	);
+	Logging::Write(logPrefix, "XorRepeatingKey16 SSE2: %.2f GB/s",
+		MeasureGigabytesPerSecond(XorRepeatingKey16Sse2, buffer, key)
+	);
+	if (SimdKernels::HasAvx2())
+	{
+		Logging::Write(logPrefix, "XorRepeatingKey16 AVX2: %.2f GB/s",
+			MeasureGigabytesPerSecond(XorRepeatingKey16Avx2, buffer, key)
+		);
+	}
+	else
+	{
+		Logging::Write(logPrefix, "XorRepeatingKey16 AVX2: not supported on this CPU");
+	}
+
+	// A key count that is not a multiple of four also covers the scalar tail of the vector path.
+	const size_t hashKeyCount = 1000003;
+	std::vector<uint8_t> hashKeys(buffer.begin(), buffer.begin() + hashKeyCount * 16);
+	std::vector<uint64_t> referenceHashes(hashKeyCount * 2);
+	std::vector<uint64_t> vectorizedHashes(hashKeyCount * 2);
+	MurmurHash3X64_128Keys16Scalar(hashKeys.data(), hashKeyCount, 0x2a, referenceHashes.data());
+	SimdKernels::MurmurHash3X64_128Keys16(hashKeys.data(), hashKeyCount, 0x2a, vectorizedHashes.data());
+	if (referenceHashes != vectorizedHashes)
+	{
+		Logging::Write(logPrefix, "MurmurHash3X64_128Keys16 output does not match the scalar reference");
+	}
+
+	Logging::Write(logPrefix, "MurmurHash3X64_128Keys16 scalar: %.1f M keys/s",
+		MeasureMillionHashesPerSecond(MurmurHash3X64_128Keys16Scalar, hashKeys)
+	);
+	if (SimdKernels::HasAvx2())
+	{
+		Logging::Write(logPrefix, "MurmurHash3X64_128Keys16 AVX2: %.1f M keys/s",
+			MeasureMillionHashesPerSecond(MurmurHash3X64_128Keys16Avx2, hashKeys)
+		);
+	}
+
+	// An odd sample count covers the scalar tail behind both vector paths.
+	std::vector<uint8_t> swapReference(buffer.begin(), buffer.begin() + (bufferSize / 2 - 2 * 37));
+	std::vector<uint8_t> swapVectorized = swapReference;
+	ByteSwap16Scalar(swapReference.data(), swapReference.data(), swapReference.size() / 2);
+	SimdKernels::ByteSwap16(swapVectorized.data(), swapVectorized.data(), swapVectorized.size() / 2);
+	if (swapReference != swapVectorized)
+	{
+		Logging::Write(logPrefix, "ByteSwap16 output does not match the scalar reference");
+	}
+
+	Logging::Write(logPrefix, "ByteSwap16 scalar: %.2f GB/s",
+		MeasureByteSwapGigabytesPerSecond(ByteSwap16Scalar, buffer)
+	);
+	Logging::Write(logPrefix, "ByteSwap16 SSE2: %.2f GB/s",
+		MeasureByteSwapGigabytesPerSecond(ByteSwap16Sse2, buffer)
+	);
+	if (SimdKernels::HasAvx2())
+	{
+		Logging::Write(logPrefix, "ByteSwap16 AVX2: %.2f GB/s",
+			MeasureByteSwapGigabytesPerSecond(ByteSwap16Avx2, buffer)
+		);
+	}
+
+	// Sample counts are odd again so every vector path also runs its scalar tail.
+	const size_t sampleCount = bufferSize / 4 - 13;
+	std::vector<float> widenedReference(sampleCount);
+	std::vector<float> widenedVectorized(sampleCount);
+	const struct
+	{
+		const char* name;
+		WidenToFloatFn scalar;
+		WidenToFloatFn sse2;
+		WidenToFloatFn avx2;
+		void (*dispatched)(const uint8_t*, float*, size_t);
+		size_t sampleSize;
+	} widenKernels[] = {
+		{ "Int16ToFloat", Int16ToFloatScalar, Int16ToFloatSse2, Int16ToFloatAvx2, SimdKernels::Int16ToFloat, 2 },
+		{ "Int24ToFloat", Int24ToFloatScalar, nullptr, Int24ToFloatAvx2, SimdKernels::Int24ToFloat, 3 },
+		{ "Int32ToFloat", Int32ToFloatScalar, Int32ToFloatSse2, Int32ToFloatAvx2, SimdKernels::Int32ToFloat, 4 }
+	};
+	for (const auto& widen : widenKernels)
+	{
+		const size_t count = (std::min)(sampleCount, buffer.size() / widen.sampleSize);
+		widen.scalar(buffer.data(), widenedReference.data(), count);
+		widen.dispatched(buffer.data(), widenedVectorized.data(), count);
+		if (std::memcmp(widenedReference.data(), widenedVectorized.data(), count * sizeof(float)) != 0)
+		{
+			Logging::Write(logPrefix, "%s output does not match the scalar reference", widen.name);
+		}
+
+		const WidenToFloatFn paths[] = { widen.scalar, widen.sse2, SimdKernels::HasAvx2() ? widen.avx2 : nullptr };
+		const char* pathNames[] = { "scalar", "SSE2", "AVX2" };
+		for (size_t path = 0; path < 3; path++)
+		{
+			if (!paths[path])
+			{
+				continue;
+			}
+			Logging::Write(logPrefix, "%s %s: %.0f M samples/s",
+				widen.name,
+				pathNames[path],
+				MeasureMillionSamplesPerSecond(
+					[&]() { paths[path](buffer.data(), widenedVectorized.data(), count); },
+					count
+				)
+			);
+		}
+	}
+
+	// Widened samples stay within [-1, 1), so scaling them up exercises the clipping as well.
+	for (size_t i = 0; i < sampleCount; i++)
+	{
+		widenedReference[i] *= 1.5f;
+	}
+	std::vector<uint8_t> narrowedReference(sampleCount * 2);
+	std::vector<uint8_t> narrowedVectorized(sampleCount * 2);
+	FloatToInt16DitheredScalar(widenedReference.data(), narrowedReference.data(), sampleCount, 12345);
+	SimdKernels::FloatToInt16Dithered(widenedReference.data(), narrowedVectorized.data(), sampleCount, 12345);
+	if (narrowedReference != narrowedVectorized)
+	{
+		Logging::Write(logPrefix, "FloatToInt16Dithered output does not match the scalar reference");
+	}
+
+	const FloatToInt16DitheredFn narrowPaths[] = {
+		FloatToInt16DitheredScalar,
+		FloatToInt16DitheredSse2,
+		SimdKernels::HasAvx2() ? FloatToInt16DitheredAvx2 : nullptr
+	};
+	const char* narrowPathNames[] = { "scalar", "SSE2", "AVX2" };
+	for (size_t path = 0; path < 3; path++)
+	{
+		if (!narrowPaths[path])
+		{
+			continue;
+		}
+		Logging::Write(logPrefix, "FloatToInt16Dithered %s: %.0f M samples/s",
+			narrowPathNames[path],
+			MeasureMillionSamplesPerSecond(
+				[&]() { narrowPaths[path](widenedReference.data(), narrowedVectorized.data(), sampleCount, 0); },
+				sampleCount
+			)
+		);
+	}
+
+	const float downmixCoefficients[2 * 6] = { 0.4f, 0.0f, 0.3f, 0.0f, 0.3f, 0.0f, 0.0f, 0.4f, 0.3f, 0.0f, 0.0f, 0.3f };
+	const size_t downmixFrames = sampleCount / 6;
+	std::vector<float> mixedReference(downmixFrames * 2);
+	std::vector<float> mixedVectorized(downmixFrames * 2);
+	DownmixToStereoScalar(widenedReference.data(), downmixFrames, 6, downmixCoefficients, mixedReference.data());
+	SimdKernels::DownmixToStereo(
+		widenedReference.data(),
+		downmixFrames,
+		6,
+		downmixCoefficients,
+		mixedVectorized.data()
+	);
+	if (std::memcmp(mixedReference.data(), mixedVectorized.data(), mixedReference.size() * sizeof(float)) != 0)
+	{
+		Logging::Write(logPrefix, "DownmixToStereo output does not match the scalar reference");
+	}
+
+	Logging::Write(logPrefix, "DownmixToStereo 5.1 scalar: %.0f M frames/s",
+		MeasureMillionSamplesPerSecond(
+			[&]()
+			{
+				DownmixToStereoScalar(
+					widenedReference.data(),
+					downmixFrames,
+					6,
+					downmixCoefficients,
+					mixedVectorized.data()
+				);
+			},
+			downmixFrames
+		)
+	);
+	Logging::Write(logPrefix, "DownmixToStereo 5.1 SSE2: %.0f M frames/s",
+		MeasureMillionSamplesPerSecond(
+			[&]()
+			{
+				DownmixToStereoSse2(
+					widenedReference.data(),
+					downmixFrames,
+					6,
+					downmixCoefficients,
+					mixedVectorized.data()
+				);
+			},
+			downmixFrames
+		)
+	);
+}